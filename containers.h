@@ -23,15 +23,35 @@
  *  - Containers (vector / array / string) using pages as backing storage with iterators (including reverse iterators)
  *    and bounds-checked at().
  *  - Small-block heap allocator enabling multiple small objects/arrays to share pages efficiently.
+ *  - Optional handle table (VM_HANDLE_COUNT) making small blocks relocatable, with incremental heap compaction.
  *
  * Recent improvements:
- *  - VMArray now uses small-heap blocks instead of dedicating entire pages, enabling better memory utilization.
+ *  - VMArray uses small-heap blocks when the array fits one block, and whole pages (compile-time indexing) otherwise.
  *  - VMArray automatically calls constructors/destructors for non-trivial types; zero-initializes trivial types.
  *  - VMVector features hybrid mode: starts with flat contiguous storage (enabling data() access) and automatically
  *    transitions to paged mode when size exceeds single-block capacity.
  *  - VMString uses a single page (no dynamic multi-page growth), but now allocates from a shared heap page instead of owning an entire page.
  *  - VMPtr<T> now allocates its object storage from shared heap pages instead of dedicating a whole page.
  *  - VMPtr<T> has a destroy() method for explicit lifetime management.
+ *  - make_vm_near() / make_vm_in() (VMAllocGroup) hint the small heap to co-locate related objects on one page.
+ *  - make_vm_batch() / destroy_vm_batch() allocate and free many same-size objects page by page.
+ *  - Optional allocation tags (VM_TAG_COUNT, VMTagScope) account heap bytes, pages, faults and write-backs per
+ *    subsystem; VMManager::report() prints them.
+ *  - Optional page-event trace (VM_TRACE_EVENTS) with Chrome trace JSON export.
+ *  - Optional online miss-ratio-curve estimation (VM_MRC) from sampled page reuse distances.
+ *  - heap_page_info() / heap_report() analyze heap fragmentation per page, with an ASCII occupancy map.
+ *  - Optional latency histograms (VM_LATENCY_STATS) for swap_in/swap_out/evict/heap_alloc with percentiles.
+ *  - Optional access-trace capture (VM_ACCESS_LOG) for offline replay with extras/vm_replay.
+ *  - Swap storage behind VMSwapBackend; VMSimSwapBackend simulates storage latency deterministically for benchmarks.
+ *  - set_frame_limit() caps resident pages; extras/vm_bench runs firmware-like workloads against it.
+ *  - VMLockSet pins a declared working set within a RAM budget; VMNoFaultScope refuses or counts blocking I/O.
+ *  - Low/high watermarks with batched reclamation (reclaim()/poll()) and memory-pressure callbacks.
+ *  - Optional log-structured swap (VM_SWAP_LOG): write-backs are appended to segments, a greedy cleaner compacts them.
+ *  - Raw block-device swap backends: SD sectors via readRAW()/writeRAW(), Linux block devices/files with O_DIRECT.
+ *  - VMUniquePtr<T> / VMSharedPtr<T> (make_vm_unique / make_vm_shared) destroy and free automatically; the shared
+ *    reference count is stored in VM next to the object.
+ *  - Objects and vector elements larger than a page live in multi-page extents that are swapped as one unit;
+ *    VMPackedVector<T> packs odd-sized trivially copyable records densely across page boundaries.
  *
  * Limitations:
  *  - VMVector data() is only available in flat mode (small vectors); returns nullptr after transition to paged mode.
@@ -50,7 +70,18 @@
  * @note Designed for Arduino environments supporting FS abstractions.
  */
 
+#if defined(__has_include)
+#if __has_include(<FS.h>)
 #include <FS.h>
+#define VM_HAVE_FS 1
+#endif
+#else
+#include <FS.h>
+#define VM_HAVE_FS 1
+#endif
+#ifndef VM_HAVE_FS
+#define VM_HAVE_FS 0          ///< 1 when the Arduino FS API is available (file-backed swap, access log).
+#endif
 #include <initializer_list>
 #include <algorithm>
 #include <cstring>
@@ -61,9 +92,745 @@
 #include <cstdlib>
 #include <utility>
 #include <new>
-
+#include <cstdio>
+#if !defined(ARDUINO)
+#include <chrono>
+#endif
+#if defined(ESP32)
+#include <esp_heap_caps.h>
+#endif
+#if defined(__linux__) && !defined(ARDUINO)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <linux/fs.h>
+#define VM_HAVE_FD_SWAP 1
+#endif
+#ifndef VM_HAVE_FD_SWAP
+#define VM_HAVE_FD_SWAP 0     ///< 1 on Linux hosts, where VMFdSwapBackend is available.
+#endif
+
+#ifndef VM_PAGE_SIZE
 #define VM_PAGE_SIZE   4096   ///< Size (in bytes) of a single virtual memory page.
+#endif
+#ifndef VM_PAGE_COUNT
 #define VM_PAGE_COUNT  16     ///< Total number of pages managed.
+#endif
+#ifndef VM_HEAP_RESERVE_PAGES
+#define VM_HEAP_RESERVE_PAGES 0 ///< Empty heap pages kept allocated to avoid alloc/release churn.
+#endif
+#ifndef VM_HANDLE_COUNT
+#define VM_HANDLE_COUNT 0     ///< Relocatable small-heap blocks (0 = handle table disabled).
+#endif
+#ifndef VM_TAG_COUNT
+#define VM_TAG_COUNT 0        ///< User allocation tags for memory accounting (0 = accounting disabled).
+#endif
+#ifndef VM_TRACE_EVENTS
+#define VM_TRACE_EVENTS 0     ///< Page-event trace ring capacity in events (0 = tracing disabled).
+#endif
+#ifndef VM_LATENCY_STATS
+#define VM_LATENCY_STATS 0    ///< 1 = keep latency histograms of swap_in/swap_out/evict/heap_alloc.
+#endif
+#ifndef VM_ACCESS_LOG
+#define VM_ACCESS_LOG 0       ///< Access-log RAM buffer in records (0 = access capture disabled).
+#endif
+#ifndef VM_MRC
+#define VM_MRC 0              ///< 1 = estimate the miss-ratio curve online (reuse distances of page accesses).
+#endif
+#ifndef VM_SWAP_LOG
+#define VM_SWAP_LOG 0         ///< 1 = log-structured swap: write-backs are appended, a cleaner compacts segments.
+#endif
+#ifndef VM_SWAP_LOG_SEGMENT_PAGES
+#define VM_SWAP_LOG_SEGMENT_PAGES 8 ///< Pages per log segment (also the largest extent in log mode).
+#endif
+#ifndef VM_SWAP_LOG_SPARE_SEGMENTS
+#define VM_SWAP_LOG_SPARE_SEGMENTS 4 ///< Log segments beyond twice those needed to hold every page (>= 2).
+#endif
+#ifndef VM_PRESSURE_CALLBACKS
+#define VM_PRESSURE_CALLBACKS 4 ///< Memory-pressure callback slots (see VMManager::add_pressure_callback()).
+#endif
+#ifndef VM_MRC_SAMPLE_SHIFT
+#define VM_MRC_SAMPLE_SHIFT 3 ///< Sample pages whose hash has this many low zero bits (rate 1/2^shift; 0 = all).
+#endif
+
+/**
+ * @brief Simulated time added to vm_micros() by VMSimSwapBackend (see VMSimCostModel::advance_clock).
+ * @return Offset in microseconds.
+ */
+inline uint32_t& vm_clock_offset_us() {
+    static uint32_t offset = 0;
+    return offset;
+}
+
+/**
+ * @brief Microsecond clock used for trace timestamps and latency histograms (wraps after ~71 minutes).
+ * @return micros() on Arduino, a steady clock on host builds, plus any simulated I/O time.
+ */
+inline uint32_t vm_micros() {
+#if defined(ARDUINO)
+    return (uint32_t)micros() + vm_clock_offset_us();
+#else
+    using namespace std::chrono;
+    return (uint32_t)duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count() + vm_clock_offset_us();
+#endif
+}
+
+/**
+ * @brief Free system heap used by the heap watermarks (see VMManager::set_watermarks()).
+ * @return Free 8-bit-capable heap bytes on ESP32, free heap on ESP8266, SIZE_MAX (unknown) elsewhere.
+ */
+inline size_t vm_free_heap() {
+#if defined(ESP32)
+    return heap_caps_get_free_size(MALLOC_CAP_8BIT);
+#elif defined(ESP8266)
+    return ESP.getFreeHeap();
+#else
+    return std::numeric_limits<size_t>::max();
+#endif
+}
+
+/**
+ * @class VMSwapBackend
+ * @brief Storage behind the swap area: a flat byte range addressed by offset.
+ *
+ * @details VMManager::begin(fs, path) uses a file on an Arduino filesystem; pass another
+ * implementation to VMManager::begin(VMSwapBackend&) to swap to raw storage or a simulator.
+ * Calls are page- or extent-sized and aligned to the page size.
+ */
+class VMSwapBackend {
+public:
+    virtual ~VMSwapBackend() {}
+    /**
+     * @brief Prepare a zero-filled swap area.
+     * @param bytes Size of the area (page count * page size).
+     * @return True on success.
+     */
+    virtual bool open(size_t bytes) = 0;
+    /**
+     * @brief Read from the swap area.
+     * @return Bytes read.
+     */
+    virtual size_t read(size_t offset, uint8_t* buf, size_t len) = 0;
+    /**
+     * @brief Write to the swap area.
+     * @return Bytes written.
+     */
+    virtual size_t write(size_t offset, const uint8_t* buf, size_t len) = 0;
+    /// Make completed writes durable.
+    virtual void flush() {}
+    /// Release the swap area (called by VMManager::end()).
+    virtual void close() {}
+};
+
+#if VM_HAVE_FS
+/**
+ * @class VMFileSwapBackend
+ * @brief Swap area in a file on an Arduino filesystem (SD, SPIFFS, LittleFS).
+ *
+ * @note Portability: avoids string mode "r+"; keeps two handles (read/write).
+ */
+class VMFileSwapBackend : public VMSwapBackend {
+public:
+    /**
+     * @brief Select the file to use on the next open().
+     * @param filesystem Filesystem.
+     * @param path File path (not copied; must stay valid).
+     */
+    void configure(fs::FS& filesystem, const char* path) {
+        fs_ = &filesystem;
+        path_ = path;
+    }
+
+    bool open(size_t bytes) override {
+        if (!fs_) return false;
+        fs_->remove(path_);
+
+        // Open a write handle first. On many Arduino FS, FILE_WRITE implies truncation.
+        // We pre-size the file by writing zeros through this handle, then keep it open.
+        write_ = fs_->open(path_, FILE_WRITE);
+        if (!write_) return false;
+        uint8_t zero[512] = {0};
+        for (size_t off = 0; off < bytes; off += sizeof(zero)) {
+            write_.seek(off);
+            write_.write(zero, std::min(sizeof(zero), bytes - off));
+        }
+        write_.flush();
+
+        // Open a separate read handle. Keeping both avoids reliance on "r+".
+        read_ = fs_->open(path_, FILE_READ);
+        if (!read_) {
+            write_.close();
+            return false;
+        }
+        return true;
+    }
+
+    size_t read(size_t offset, uint8_t* buf, size_t len) override {
+        read_.seek(offset);
+        return read_.read(buf, len);
+    }
+
+    size_t write(size_t offset, const uint8_t* buf, size_t len) override {
+        write_.seek(offset);
+        return write_.write(buf, len);
+    }
+
+    void flush() override { write_.flush(); }
+
+    void close() override {
+        // Flush and close both handles if present.
+        if (write_) {
+            write_.flush();
+            write_.close();
+        }
+        if (read_) read_.close();
+    }
+
+private:
+    fs::FS* fs_ = nullptr;       ///< Filesystem.
+    const char* path_ = nullptr; ///< Swap file path.
+    fs::File read_;              ///< Read-only handle (portable alternative to "r+").
+    fs::File write_;             ///< Write handle (kept open to avoid repeated truncation).
+};
+#endif // VM_HAVE_FS
+
+/**
+ * @class VMBlockSwapBackend
+ * @brief Swap area on a raw block device: a run of whole blocks, no filesystem in between.
+ *
+ * @details Subclasses provide block transfers and the device geometry. Block-aligned requests
+ * into a suitably aligned buffer go straight to the device; anything else goes through an
+ * aligned bounce buffer, and writes that cover a block only partly read it first. With
+ * VM_PAGE_SIZE a multiple of the block size, every page fault and write-back is a single
+ * transfer.
+ */
+class VMBlockSwapBackend : public VMSwapBackend {
+public:
+    /// Frees the bounce buffer; subclasses holding a device call close() in their own destructor.
+    ~VMBlockSwapBackend() override { release(); }
+
+    bool open(size_t bytes) override {
+        release();
+        Geometry g;
+        if (!device_open(bytes, g)) return fail_open();
+        if (g.block_size == 0 || g.first_block > g.blocks) return fail_open();
+        const uint64_t avail = g.blocks - g.first_block;
+        const uint64_t need = (bytes + g.block_size - 1) / g.block_size;
+        if (need > avail || (g.region_blocks && need > g.region_blocks)) return fail_open();
+        block_size_ = g.block_size;
+        first_block_ = g.first_block;
+        align_ = g.buffer_align ? g.buffer_align : 1;
+        bounce_blocks_ = std::max<size_t>(1, (VM_PAGE_SIZE + block_size_ - 1) / block_size_);
+        bounce_raw_ = static_cast<uint8_t*>(malloc(bounce_blocks_ * block_size_ + align_ - 1));
+        if (!bounce_raw_) return fail_open();
+        bounce_ = bounce_raw_ + (align_ - (uintptr_t)bounce_raw_ % align_) % align_;
+        size_ = bytes;
+
+        // Zero the swap area (contract of open()), a bounce buffer at a time.
+        memset(bounce_, 0, bounce_blocks_ * block_size_);
+        for (uint64_t b = 0; b < need; b += bounce_blocks_) {
+            if (!write_blocks(first_block_ + b, bounce_, (size_t)std::min<uint64_t>(bounce_blocks_, need - b))) {
+                release();
+                return false;
+            }
+        }
+        reset_stats();
+        return true;
+    }
+
+    size_t read(size_t offset, uint8_t* buf, size_t len) override {
+        if (!bounce_ || offset >= size_) return 0;
+        len = std::min(len, size_ - offset);
+        size_t done = 0;
+        while (done < len) {
+            const size_t pos = offset + done;
+            const uint64_t block = first_block_ + pos / block_size_;
+            const size_t skip = pos % block_size_;
+            const size_t rest = len - done;
+            uint8_t* dst = buf + done;
+            if (skip == 0 && rest >= block_size_ && (uintptr_t)dst % align_ == 0) {
+                const size_t n = rest / block_size_;
+                if (!read_blocks(block, dst, n)) break;
+                ++reads_;
+                done += n * block_size_;
+                continue;
+            }
+            const size_t n = std::min(bounce_blocks_, (skip + rest + block_size_ - 1) / block_size_);
+            if (!read_blocks(block, bounce_, n)) break;
+            ++reads_;
+            const size_t chunk = std::min(n * block_size_ - skip, rest);
+            memcpy(dst, bounce_ + skip, chunk);
+            done += chunk;
+        }
+        return done;
+    }
+
+    size_t write(size_t offset, const uint8_t* buf, size_t len) override {
+        if (!bounce_ || offset >= size_) return 0;
+        len = std::min(len, size_ - offset);
+        size_t done = 0;
+        while (done < len) {
+            const size_t pos = offset + done;
+            const uint64_t block = first_block_ + pos / block_size_;
+            const size_t skip = pos % block_size_;
+            const size_t rest = len - done;
+            const uint8_t* src = buf + done;
+            if (skip == 0 && rest >= block_size_ && (uintptr_t)src % align_ == 0) {
+                const size_t n = rest / block_size_;
+                if (!write_blocks(block, src, n)) break;
+                ++writes_;
+                done += n * block_size_;
+                continue;
+            }
+            const size_t n = std::min(bounce_blocks_, (skip + rest + block_size_ - 1) / block_size_);
+            const size_t chunk = std::min(n * block_size_ - skip, rest);
+            if (skip || skip + chunk < n * block_size_) {
+                // Partly covered block(s): keep the bytes around the new data.
+                if (!read_blocks(block, bounce_, n)) break;
+                ++reads_;
+                ++partial_writes_;
+            }
+            memcpy(bounce_ + skip, src, chunk);
+            if (!write_blocks(block, bounce_, n)) break;
+            ++writes_;
+            done += chunk;
+        }
+        return done;
+    }
+
+    void close() override { release(); }
+
+    /// Zero the transfer counters.
+    void reset_stats() { reads_ = writes_ = partial_writes_ = 0; }
+
+    size_t block_size() const { return block_size_; }            ///< Device block size (0 before open()).
+    uint32_t reads() const { return reads_; }                    ///< Device read transfers.
+    uint32_t writes() const { return writes_; }                  ///< Device write transfers.
+    uint32_t partial_writes() const { return partial_writes_; }  ///< Writes that needed a read-modify-write.
+
+protected:
+    /// Device geometry reported by device_open().
+    struct Geometry {
+        size_t block_size = 512;    ///< Bytes per block (transfer unit and alignment of offsets).
+        uint64_t blocks = 0;        ///< Blocks on the device.
+        uint64_t first_block = 0;   ///< First block of the swap region.
+        uint64_t region_blocks = 0; ///< Blocks reserved for swap (0 = up to the end of the device).
+        size_t buffer_align = 1;    ///< Required memory alignment of transfer buffers.
+    };
+
+    /**
+     * @brief Open the device.
+     * @param bytes Swap area size requested by VMManager.
+     * @param g Output geometry.
+     * @return True on success.
+     */
+    virtual bool device_open(size_t bytes, Geometry& g) = 0;
+    /// Close the device (after device_open() succeeded).
+    virtual void device_close() {}
+    /**
+     * @brief Read whole blocks.
+     * @param block First block (absolute on the device).
+     * @param buf Destination, aligned to Geometry::buffer_align.
+     * @param count Blocks to read.
+     * @return True on success.
+     */
+    virtual bool read_blocks(uint64_t block, uint8_t* buf, size_t count) = 0;
+    /**
+     * @brief Write whole blocks.
+     * @param block First block (absolute on the device).
+     * @param buf Source, aligned to Geometry::buffer_align.
+     * @param count Blocks to write.
+     * @return True on success.
+     */
+    virtual bool write_blocks(uint64_t block, const uint8_t* buf, size_t count) = 0;
+
+private:
+    bool fail_open() {
+        device_close();
+        return false;
+    }
+
+    void release() {
+        if (!bounce_raw_) return;
+        free(bounce_raw_);
+        bounce_raw_ = bounce_ = nullptr;
+        size_ = 0;
+        device_close();
+    }
+
+    size_t block_size_ = 0;         ///< Bytes per block.
+    uint64_t first_block_ = 0;      ///< First block of the swap region.
+    size_t align_ = 1;              ///< Buffer alignment for direct transfers.
+    size_t size_ = 0;               ///< Swap size in bytes.
+    size_t bounce_blocks_ = 0;      ///< Bounce buffer size in blocks (at least one page).
+    uint8_t* bounce_raw_ = nullptr; ///< Bounce allocation.
+    uint8_t* bounce_ = nullptr;     ///< Aligned bounce buffer (nullptr = closed).
+    uint32_t reads_ = 0, writes_ = 0, partial_writes_ = 0;
+};
+
+/**
+ * @class VMSdRawSwapBackend
+ * @brief Swap area in raw SD card sectors, bypassing FAT.
+ * @tparam Card Card driver with readRAW(uint8_t*, uint32_t), writeRAW(uint8_t*, uint32_t),
+ *         numSectors() and sectorSize(), such as fs::SDFS (the ESP32 SD object).
+ *
+ * @details The sectors must not belong to a filesystem: use a partition of its own or the space
+ * after the FAT partition. One readRAW()/writeRAW() call per sector.
+ *
+ * @code
+ * VMSdRawSwapBackend<fs::SDFS> raw;
+ * raw.configure(SD, first_sector, sector_count);
+ * VMManager::instance().begin(raw);
+ * @endcode
+ */
+template<typename Card>
+class VMSdRawSwapBackend : public VMBlockSwapBackend {
+public:
+    /**
+     * @brief Select the sectors to use on the next open().
+     * @param card Mounted card driver.
+     * @param first_sector First sector of the swap region.
+     * @param sector_count Sectors reserved for swap (0 = up to the end of the card).
+     */
+    void configure(Card& card, uint32_t first_sector, uint32_t sector_count = 0) {
+        card_ = &card;
+        first_ = first_sector;
+        count_ = sector_count;
+    }
+
+protected:
+    bool device_open(size_t, Geometry& g) override {
+        if (!card_) return false;
+        g.block_size = card_->sectorSize();
+        g.blocks = card_->numSectors();
+        g.first_block = first_;
+        g.region_blocks = count_;
+        g.buffer_align = 4; // DMA-capable transfers
+        return g.block_size > 0;
+    }
+
+    bool read_blocks(uint64_t block, uint8_t* buf, size_t count) override {
+        for (size_t i = 0; i < count; ++i)
+            if (!card_->readRAW(buf + i * block_size(), (uint32_t)(block + i))) return false;
+        return true;
+    }
+
+    bool write_blocks(uint64_t block, const uint8_t* buf, size_t count) override {
+        for (size_t i = 0; i < count; ++i)
+            if (!card_->writeRAW(const_cast<uint8_t*>(buf + i * block_size()), (uint32_t)(block + i))) return false;
+        return true;
+    }
+
+private:
+    Card* card_ = nullptr; ///< Card driver.
+    uint32_t first_ = 0;   ///< First sector of the swap region.
+    uint32_t count_ = 0;   ///< Sectors reserved (0 = to the end).
+};
+
+#if VM_HAVE_FD_SWAP
+/**
+ * @class VMFdSwapBackend
+ * @brief Swap area on a Linux block device or preallocated file, with O_DIRECT I/O.
+ *
+ * @details The page cache is bypassed where the filesystem supports O_DIRECT (otherwise the
+ * file is used buffered); buffers, offsets and lengths are kept 4096-byte aligned, which
+ * satisfies any logical block size up to 4 KiB. A regular file shorter than the swap area is
+ * extended with posix_fallocate(). Writes are synchronous pwrite() calls; flush() does not sync,
+ * since open() zeroes the area and swap content never has to survive a restart.
+ */
+class VMFdSwapBackend : public VMBlockSwapBackend {
+public:
+    static constexpr size_t kAlign = 4096; ///< Block size and buffer alignment used with O_DIRECT.
+
+    ~VMFdSwapBackend() override { close(); }
+
+    /**
+     * @brief Select the device or file to use on the next open().
+     * @param path Block device (e.g. /dev/sdb2) or file path (not copied; must stay valid).
+     * @param offset Byte offset of the swap region (multiple of kAlign).
+     * @param max_bytes Bytes reserved for swap (0 = up to the end of a device, or as needed for a file).
+     */
+    void configure(const char* path, uint64_t offset = 0, uint64_t max_bytes = 0) {
+        path_ = path;
+        offset_ = offset;
+        max_bytes_ = max_bytes;
+    }
+
+    /// True if the last open() got O_DIRECT (false: the filesystem refused it, I/O is buffered).
+    bool direct() const { return direct_; }
+
+protected:
+    bool device_open(size_t bytes, Geometry& g) override {
+        if (!path_ || offset_ % kAlign) return false;
+        direct_ = false;
+#ifdef O_DIRECT
+        fd_ = ::open(path_, O_RDWR | O_CREAT | O_CLOEXEC | O_DIRECT, 0600);
+        direct_ = fd_ >= 0;
+#endif
+        if (fd_ < 0) fd_ = ::open(path_, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (fd_ < 0) return false;
+        struct stat st;
+        uint64_t size = 0;
+        if (fstat(fd_, &st) != 0) return false;
+        if (S_ISBLK(st.st_mode)) {
+            if (ioctl(fd_, BLKGETSIZE64, &size) != 0) return false;
+        } else {
+            const uint64_t end = offset_ + (bytes + kAlign - 1) / kAlign * kAlign;
+            if ((uint64_t)st.st_size < end && posix_fallocate(fd_, 0, (off_t)end) != 0) return false;
+            size = std::max<uint64_t>((uint64_t)st.st_size, end);
+        }
+        g.block_size = kAlign;
+        g.blocks = size / kAlign;
+        g.first_block = offset_ / kAlign;
+        g.region_blocks = max_bytes_ / kAlign;
+        g.buffer_align = kAlign;
+        return true;
+    }
+
+    void device_close() override {
+        if (fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+    }
+
+    bool read_blocks(uint64_t block, uint8_t* buf, size_t count) override {
+        const size_t len = count * kAlign;
+        return pread(fd_, buf, len, (off_t)(block * kAlign)) == (ssize_t)len;
+    }
+
+    bool write_blocks(uint64_t block, const uint8_t* buf, size_t count) override {
+        const size_t len = count * kAlign;
+        return pwrite(fd_, buf, len, (off_t)(block * kAlign)) == (ssize_t)len;
+    }
+
+private:
+    const char* path_ = nullptr; ///< Device or file path.
+    uint64_t offset_ = 0;        ///< Byte offset of the swap region.
+    uint64_t max_bytes_ = 0;     ///< Bytes reserved (0 = no limit).
+    int fd_ = -1;                ///< Open descriptor (-1 = closed).
+    bool direct_ = false;        ///< O_DIRECT in effect.
+};
+#endif // VM_HAVE_FD_SWAP
+
+/**
+ * @struct VMSimCostModel
+ * @brief Cost model of VMSimSwapBackend (defaults resemble a mid-range SD card over SPI).
+ */
+struct VMSimCostModel {
+    uint32_t read_latency_us   = 300;   ///< Fixed cost per read operation.
+    uint32_t write_latency_us  = 900;   ///< Fixed cost per write operation.
+    uint32_t read_kb_per_s     = 4000;  ///< Read bandwidth.
+    uint32_t write_kb_per_s    = 1500;  ///< Write bandwidth.
+    uint32_t sector_size       = 512;   ///< Writes are rounded out to whole sectors; partial sectors add a read-modify-write.
+    uint32_t random_write_us   = 2000;  ///< Extra cost of a write that does not continue the previous one (FTL/FAT remapping).
+    uint32_t gc_stall_permille = 5;     ///< Chance per write (in 1/1000) of a garbage-collection stall.
+    uint32_t gc_stall_us       = 40000; ///< Duration of a stall.
+    uint32_t seed              = 1;     ///< Seed of the stall generator (same seed, same numbers).
+    bool     advance_clock     = true;  ///< Add simulated time to vm_micros() so traces and histograms see it.
+};
+
+/**
+ * @class VMSimSwapBackend
+ * @brief Deterministic in-memory swap area with a storage cost model, for reproducible benchmarks.
+ *
+ * @details Data lives in a RAM buffer; every operation is charged to a virtual clock according to
+ * VMSimCostModel (fixed latency, bandwidth, sector write amplification, seeded GC stalls). Nothing
+ * sleeps, so runs are fast and the reported time is identical for identical access sequences.
+ *
+ * @code
+ * VMSimSwapBackend sim;             // default SD-like model
+ * VMManager::instance().begin(sim);
+ * run_workload();
+ * printf("%lu us simulated I/O\n", (unsigned long)sim.elapsed_us());
+ * @endcode
+ */
+class VMSimSwapBackend : public VMSwapBackend {
+public:
+    /// Backend with the default cost model.
+    VMSimSwapBackend() {}
+    /// Backend with a custom cost model.
+    explicit VMSimSwapBackend(const VMSimCostModel& model) : model_(model) {}
+    ~VMSimSwapBackend() override { close(); }
+    VMSimSwapBackend(const VMSimSwapBackend&) = delete;
+    VMSimSwapBackend& operator=(const VMSimSwapBackend&) = delete;
+
+    bool open(size_t bytes) override {
+        close();
+        data_ = static_cast<uint8_t*>(calloc(bytes ? bytes : 1, 1));
+        if (!data_) return false;
+        size_ = bytes;
+        reset_stats();
+        return true;
+    }
+
+    size_t read(size_t offset, uint8_t* buf, size_t len) override {
+        if (!data_ || offset >= size_) return 0;
+        len = std::min(len, size_ - offset);
+        memcpy(buf, data_ + offset, len);
+        ++reads_;
+        bytes_read_ += len;
+        charge(model_.read_latency_us + transfer_us(len, model_.read_kb_per_s));
+        return len;
+    }
+
+    size_t write(size_t offset, const uint8_t* buf, size_t len) override {
+        if (!data_ || offset >= size_) return 0;
+        len = std::min(len, size_ - offset);
+        memcpy(data_ + offset, buf, len);
+        ++writes_;
+        // Whole sectors are programmed; a partially covered sector is read first.
+        const size_t sec = model_.sector_size ? model_.sector_size : 1;
+        const size_t first = offset / sec;
+        const size_t last = (offset + len + sec - 1) / sec;
+        const size_t physical = (last - first) * sec;
+        uint32_t cost = model_.write_latency_us + transfer_us(physical, model_.write_kb_per_s);
+        if (offset != next_write_) {
+            ++random_writes_;
+            cost += model_.random_write_us;
+        }
+        next_write_ = offset + len;
+        size_t partial = (offset % sec ? 1 : 0) + ((offset + len) % sec ? 1 : 0);
+        if (partial == 2 && last - first == 1) partial = 1; // both ends in the same sector
+        if (partial) cost += (uint32_t)partial * (model_.read_latency_us + transfer_us(sec, model_.read_kb_per_s));
+        bytes_written_ += physical;
+        if (model_.gc_stall_permille && next_random() % 1000 < model_.gc_stall_permille) {
+            ++stalls_;
+            cost += model_.gc_stall_us;
+        }
+        charge(cost);
+        return len;
+    }
+
+    void close() override {
+        free(data_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    /// Zero the counters and the virtual clock and re-seed the stall generator.
+    void reset_stats() {
+        reads_ = writes_ = stalls_ = random_writes_ = 0;
+        bytes_read_ = bytes_written_ = 0;
+        next_write_ = std::numeric_limits<size_t>::max();
+        elapsed_us_ = 0;
+        rng_ = model_.seed ? model_.seed : 1;
+    }
+
+    uint64_t elapsed_us() const { return elapsed_us_; }       ///< Simulated I/O time.
+    uint32_t reads() const { return reads_; }                 ///< Read operations.
+    uint32_t writes() const { return writes_; }               ///< Write operations.
+    uint64_t bytes_read() const { return bytes_read_; }       ///< Bytes read.
+    uint64_t bytes_written() const { return bytes_written_; } ///< Bytes programmed (after sector rounding).
+    uint32_t stalls() const { return stalls_; }               ///< GC stalls injected.
+    uint32_t random_writes() const { return random_writes_; } ///< Writes that did not continue the previous one.
+    const VMSimCostModel& model() const { return model_; }    ///< Active cost model.
+
+private:
+    /// Microseconds to move len bytes at kb_per_s.
+    static uint32_t transfer_us(size_t len, uint32_t kb_per_s) {
+        return kb_per_s ? (uint32_t)((uint64_t)len * 1000000u / ((uint64_t)kb_per_s * 1024u)) : 0;
+    }
+
+    /// xorshift32: deterministic and cheap.
+    uint32_t next_random() {
+        rng_ ^= rng_ << 13;
+        rng_ ^= rng_ >> 17;
+        rng_ ^= rng_ << 5;
+        return rng_;
+    }
+
+    void charge(uint32_t us) {
+        elapsed_us_ += us;
+        if (model_.advance_clock) vm_clock_offset_us() += us;
+    }
+
+    VMSimCostModel model_;          ///< Cost model.
+    uint8_t* data_ = nullptr;       ///< Swap contents.
+    size_t size_ = 0;               ///< Swap size in bytes.
+    uint64_t elapsed_us_ = 0;       ///< Virtual clock.
+    uint32_t reads_ = 0, writes_ = 0, stalls_ = 0, random_writes_ = 0;
+    size_t next_write_ = std::numeric_limits<size_t>::max(); ///< End of the previous write.
+    uint64_t bytes_read_ = 0, bytes_written_ = 0;
+    uint32_t rng_ = 1;              ///< Stall generator state.
+};
+
+/**
+ * @class VMLatencyHistogram
+ * @brief Log-linear latency histogram (HdrHistogram-style) with constant-time recording.
+ *
+ * @details Values up to 7 us get exact buckets; above that each power of two is split into
+ * 8 linear sub-buckets, so a reported percentile is at most 12.5% above the true value.
+ * Values from 2^26 us (about 67 s) up share the last bucket. Uses 776 bytes of RAM.
+ */
+class VMLatencyHistogram {
+public:
+    /// Record one latency sample in microseconds.
+    void record(uint32_t us) {
+        ++counts_[bucket_of(us)];
+        ++total_;
+        if (us > max_) max_ = us;
+    }
+
+    /// Number of recorded samples.
+    uint32_t count() const { return total_; }
+
+    /// Largest recorded sample (exact).
+    uint32_t max() const { return max_; }
+
+    /**
+     * @brief Latency at or below which a fraction of the samples fall.
+     * @param q Quantile in [0, 1] (0.5 = p50, 0.99 = p99, 0.999 = p999).
+     * @return Upper bound of the bucket holding that sample (capped at max()); 0 without samples.
+     */
+    uint32_t percentile(float q) const {
+        if (total_ == 0) return 0;
+        uint32_t rank = (uint32_t)(q * (float)total_ + 0.5f);
+        if (rank < 1) rank = 1;
+        if (rank > total_) rank = total_;
+        uint32_t seen = 0;
+        for (size_t b = 0; b < kBuckets; ++b) {
+            seen += counts_[b];
+            if (seen >= rank) return std::min(bucket_high(b), max_);
+        }
+        return max_;
+    }
+
+    /// Discard all samples.
+    void reset() {
+        for (size_t b = 0; b < kBuckets; ++b) counts_[b] = 0;
+        total_ = 0;
+        max_ = 0;
+    }
+
+private:
+    static constexpr unsigned kSubBits = 3;                     ///< log2 of sub-buckets per power of two.
+    static constexpr unsigned kSub     = 1u << kSubBits;        ///< Sub-buckets per power of two.
+    static constexpr unsigned kMaxExp  = 26;                    ///< Highest power of two with its own buckets.
+    static constexpr size_t   kBuckets = kSub + (kMaxExp - kSubBits + 1) * kSub; ///< 192 buckets.
+
+    /// Bucket index of a value.
+    static size_t bucket_of(uint32_t v) {
+        if (v < kSub) return v;
+        unsigned e = 31;
+        while (!(v >> e)) --e; // floor(log2(v)) >= kSubBits
+        if (e > kMaxExp) return kBuckets - 1;
+        return kSub + (size_t)(e - kSubBits) * kSub + ((v >> (e - kSubBits)) & (kSub - 1));
+    }
+
+    /// Largest value that maps to bucket b.
+    static uint32_t bucket_high(size_t b) {
+        if (b < kSub) return (uint32_t)b;
+        const unsigned e = (unsigned)((b - kSub) / kSub) + kSubBits;
+        const uint32_t sub = (uint32_t)((b - kSub) % kSub);
+        const uint64_t lo = ((uint64_t)(kSub + sub)) << (e - kSubBits);
+        const uint64_t hi = lo + (1ull << (e - kSubBits)) - 1;
+        return hi > 0xFFFFFFFFull ? 0xFFFFFFFFu : (uint32_t)hi;
+    }
+
+    uint32_t counts_[kBuckets] = {}; ///< Samples per bucket.
+    uint32_t total_ = 0;             ///< Samples recorded.
+    uint32_t max_ = 0;               ///< Largest sample.
+};
 
 /**
  * @struct VMPage
@@ -74,18 +841,31 @@ struct VMPage {
     bool  in_ram;        ///< True if the page currently has a RAM buffer.
     bool  can_free_ram;  ///< True if RAM can be released after swapping out.
     bool  dirty;         ///< True if RAM has unsaved modifications.
-    bool  zero_filled;   ///< True if page content is known zero.
+    bool  zero_filled;   ///< True if page content (RAM and swap slot) is known zero.
     bool  is_heap;       ///< True if page is managed as a small-block heap page.
+    uint8_t owner_tag;   ///< Accounting tag charged for holding the page (tag current when it was allocated).
+    uint8_t io_tag;      ///< Accounting tag charged for faults/write-backs (heap pages: last block allocated or written).
     uint8_t* ram_addr;   ///< Pointer to RAM buffer (if in_ram).
     size_t swap_offset;  ///< Offset in swap file where page content is stored.
     uint64_t last_access;///< Monotonic access counter (for potential eviction heuristics).
+    int   extent_head;   ///< First page of the extent this page belongs to, or -1 for a plain page.
+    size_t extent_len;   ///< Number of pages in the extent (head page only; 0 otherwise).
+    uint16_t heap_live;  ///< Live block count of a heap page (mirror of HeapHeader::live).
+    uint32_t heap_total_free;   ///< Free payload bytes of a heap page (mirror of HeapHeader::total_free).
+    uint32_t heap_largest_free; ///< Largest free block of a heap page (0 if none).
+    uint32_t generation; ///< Renewed whenever ram_addr is freed/replaced, the page is cleaned or blocks move; validates cached pointers.
+    uint8_t pin_count;   ///< VMLockSet pins (unit head only); a pinned unit is never evicted, released from RAM or compacted.
 };
 
 // Forward declarations for friend declarations
 template<typename T> class VMPtr;
 template<typename T> class VMVector;
+template<typename T> class VMPackedVector;
 template<typename T, size_t N> class VMArray;
 class VMString;
+class VMAllocGroup;
+class VMLockSet;
+class VMNoFaultScope;
 
 /**
  * @class VMManager
@@ -113,6 +893,70 @@ public:
         bool reuse_swap_data  = false;  ///< Load existing swap content instead of zeroing.
     };
 
+    /**
+     * @struct TagStats
+     * @brief Live memory accounting of one allocation tag (see register_tag()).
+     */
+    struct TagStats {
+        const char* name     = nullptr; ///< Name given to register_tag() ("untagged" for tag 0).
+        uint32_t heap_bytes  = 0;       ///< Payload bytes of live small-heap blocks.
+        uint32_t heap_blocks = 0;       ///< Number of live small-heap blocks.
+        uint32_t pages       = 0;       ///< Pages held (heap pages count for the tag that opened them).
+        uint32_t faults      = 0;       ///< Swap-ins charged to the tag.
+        uint32_t writebacks  = 0;       ///< Dirty write-backs to the swap file charged to the tag.
+    };
+
+    /**
+     * @struct HeapPageInfo
+     * @brief Occupancy and fragmentation of one small-heap page (see heap_page_info()).
+     */
+    struct HeapPageInfo {
+        int      page = -1;          ///< Page index.
+        uint16_t live_blocks = 0;    ///< Used blocks.
+        uint16_t pinned_blocks = 0;  ///< Used blocks without a handle (cannot be compacted).
+        uint16_t free_blocks = 0;    ///< Free blocks.
+        uint32_t live_bytes = 0;     ///< Payload bytes of used blocks.
+        uint32_t free_bytes = 0;     ///< Payload bytes of free blocks.
+        uint32_t largest_free = 0;   ///< Largest free block (largest allocation that still fits).
+        uint32_t header_bytes = 0;   ///< Page header plus block headers.
+        float    fragmentation = 0;  ///< External fragmentation: 1 - largest_free / free_bytes.
+        uint16_t free_hist[8] = {};  ///< Free blocks by payload size: <16, <32, <64, ... <1024, >=1024 bytes.
+        char     map[65] = {};       ///< ASCII map, one char per 1/64 page: '#' pinned, '=' relocatable, '.' free, ':' mixed.
+    };
+
+    /**
+     * @brief Kind of a recorded trace event.
+     */
+    enum TraceType : uint8_t {
+        TRACE_SWAP_IN = 0,  ///< Unit loaded; arg = bytes read (0 if zero-filled without I/O).
+        TRACE_SWAP_OUT,     ///< Unit cleaned/released; arg = bytes written (0 if clean).
+        TRACE_EVICT,        ///< LRU victim chosen; arg = 1 if it was dirty; reason says why.
+        TRACE_HEAP_ALLOC,   ///< Small block(s) allocated; arg = payload bytes.
+        TRACE_HEAP_FREE     ///< Small block freed; arg = payload bytes.
+    };
+
+    /**
+     * @brief Why a trace event happened (currently used for TRACE_EVICT).
+     */
+    enum TraceReason : uint8_t {
+        TRACE_REASON_NONE = 0,   ///< Not applicable.
+        TRACE_REASON_RAM_FULL,   ///< malloc() failed or the frame limit was reached while loading or allocating a page.
+        TRACE_REASON_RECLAIM     ///< Evicted ahead of demand to restore the high watermark (reclaim()/poll()).
+    };
+
+    /**
+     * @struct TraceEvent
+     * @brief One entry of the page-event trace ring (16 bytes).
+     */
+    struct TraceEvent {
+        uint32_t ts_us;  ///< Start time (vm_micros()).
+        uint32_t dur_us; ///< Duration in microseconds.
+        uint32_t arg;    ///< Type-specific argument (see TraceType).
+        int16_t  page;   ///< Page index (head page for extents; -1 if none).
+        uint8_t  type;   ///< TraceType.
+        uint8_t  reason; ///< TraceReason.
+    };
+
     /**
      * @brief Get singleton instance.
      * @return Reference to VMManager.
@@ -122,6 +966,7 @@ public:
         return inst;
     }
 
+#if VM_HAVE_FS
     /**
      * @brief Initialize the manager and create a fresh swap file.
      * @param filesystem Filesystem to use (e.g. SPIFFS / LittleFS).
@@ -133,28 +978,22 @@ public:
      */
     bool begin(fs::FS& filesystem, const char* swap_path) {
         if (started) end();
-        fs = &filesystem;
-        fs->remove(swap_path);
-
-        // Open a write handle first. On many Arduino FS, FILE_WRITE implies truncation.
-        // We will pre-size the file by writing zeros through this handle, then keep it open.
-        swap_write = fs->open(swap_path, FILE_WRITE);
-        if (!swap_write) return false;
-
-        // Pre-size the file to the required number of pages by writing zeros.
-        uint8_t zero[VM_PAGE_SIZE] = {0};
-        for (size_t i = 0; i < page_count; i++) {
-            swap_write.seek(i * page_size);
-            swap_write.write(zero, page_size);
-        }
-        swap_write.flush();
+        file_backend.configure(filesystem, swap_path);
+        return begin(file_backend);
+    }
+#endif
 
-        // Open a separate read handle. Keeping both avoids reliance on "r+".
-        swap_read = fs->open(swap_path, FILE_READ);
-        if (!swap_read) {
-            swap_write.close();
-            return false;
-        }
+    /**
+     * @brief Initialize the manager on a custom swap backend (raw storage, simulator, ...).
+     * @param swap Backend; must outlive the session (until end()).
+     * @return True on success.
+     *
+     * @note This is part of the minimal public API that user code may call.
+     */
+    bool begin(VMSwapBackend& swap) {
+        if (started) end();
+        if (!swap.open(swap_bytes())) return false;
+        backend = &swap;
 
         // Initialize page table.
         for (size_t i = 0; i < page_count; i++) {
@@ -164,10 +1003,29 @@ public:
             pages[i].dirty        = false;
             pages[i].zero_filled  = true;
             pages[i].is_heap      = false;
+            pages[i].owner_tag    = 0;
+            pages[i].io_tag       = 0;
+            pages[i].pin_count    = 0;
             pages[i].ram_addr     = nullptr;
-            pages[i].swap_offset  = i * page_size;
+            pages[i].swap_offset  = SWAP_LOG ? 0 : i * page_size; // log mode: set on first write-back
             pages[i].last_access  = 0;
+            pages[i].extent_head  = -1;
+            pages[i].extent_len   = 0;
+            pages[i].heap_live    = 0;
+            pages[i].heap_total_free   = 0;
+            pages[i].heap_largest_free = 0;
+            pages[i].generation = ++generation_tick; // invalidate pointers cached during a previous session
         }
+        for (size_t h = 0; h < HANDLE_SLOTS; ++h) handles[h].page = -1;
+        for (size_t t = 0; t < TAG_SLOTS; ++t) {
+            const char* name = tag_table[t].name;
+            tag_table[t] = TagStats();
+            tag_table[t].name = name;
+        }
+        current_tag = 0;
+        no_fault_count = 0;
+        log_reset();
+        mrc_reset();
         access_tick = 0;
         started = true;
         return true;
@@ -191,6 +1049,7 @@ public:
      */
     void end() {
         if (!started) return;
+        access_log_end();
         for (size_t i = 0; i < page_count; i++) {
             if (pages[i].allocated) {
                 swap_out((int)i, false);
@@ -200,15 +1059,9 @@ public:
                 pages[i].ram_addr = nullptr;
             }
         }
-        // Flush and close both handles if present.
-        if (swap_write) {
-            swap_write.flush();
-            swap_write.close();
-        }
-        if (swap_read) {
-            swap_read.close();
-        }
-        fs = nullptr;
+        backend->flush();
+        backend->close();
+        backend = nullptr;
         started = false;
     }
 
@@ -228,6 +1081,735 @@ public:
      */
     size_t get_page_count() const { return page_count; }
 
+    /**
+     * @brief Cap the number of pages held in RAM at once.
+     * @param frames Maximum resident pages (0 = limited only by malloc(); 1 is raised to 2).
+     *
+     * @details When a page must be loaded and the cap is reached, LRU pages are evicted first, as
+     * when malloc() fails. Use it to leave heap for the rest of the firmware, or to reproduce
+     * device memory pressure in host builds and benchmarks. Copies between two pages (container
+     * growth, compaction) need both resident at once, so the cap is at least 2; those paths also
+     * pin their source, so loading the destination never evicts the page just read.
+     *
+     * @note This is part of the minimal public API that user code may call.
+     */
+    void set_frame_limit(size_t frames) { frame_limit = frames == 1 ? 2 : frames; }
+
+    /**
+     * @brief Get the resident page cap.
+     * @return Maximum resident pages (0 = unlimited).
+     *
+     * @note Minimal public accessor; safe for user code.
+     */
+    size_t get_frame_limit() const { return frame_limit; }
+
+    /**
+     * @brief Count pages currently held in RAM.
+     * @return Resident pages (extent members count individually).
+     *
+     * @note Minimal public accessor; safe for user code.
+     */
+    size_t resident_frames() const {
+        size_t n = 0;
+        for (size_t i = 0; i < page_count; ++i)
+            if (pages[i].in_ram && pages[i].ram_addr) ++n;
+        return n;
+    }
+
+    /**
+     * @brief Count pages held in RAM by VMLockSet pins.
+     * @return Pinned resident pages (extent members count individually).
+     *
+     * @note Minimal public accessor; safe for user code.
+     */
+    size_t pinned_frames() const {
+        size_t n = 0;
+        for (size_t i = 0; i < page_count; ++i)
+            if (pages[i].allocated && pages[unit_head((int)i)].pin_count) ++n;
+        return n;
+    }
+
+    /**
+     * @brief Pages that lock sets may pin in total.
+     * @return frame limit - 1 with a frame limit (one frame stays available for paging), else page count - 1.
+     *
+     * @note Minimal public accessor; safe for user code.
+     */
+    size_t pin_budget() const {
+        const size_t frames = frame_limit ? frame_limit : page_count;
+        return frames ? frames - 1 : 0;
+    }
+
+    /**
+     * @brief Blocking swap I/O attempted inside VMNoFaultScope since begin() or no_fault_reset().
+     * @return Refused (strict scope) or allowed-but-counted attempts: swap-ins that read swap and
+     *         evictions that had to write a dirty page back.
+     *
+     * @note Minimal public accessor; safe for user code.
+     */
+    uint32_t no_fault_violations() const { return no_fault_count; }
+
+    /**
+     * @brief Zero the no-fault violation counter.
+     *
+     * @note This is part of the minimal public API that user code may call.
+     */
+    void no_fault_reset() { no_fault_count = 0; }
+
+    /**
+     * @brief Memory-pressure level passed to pressure callbacks.
+     */
+    enum PressureLevel : uint8_t {
+        PRESSURE_LOW = 1, ///< Below a low watermark: shrink caches.
+        PRESSURE_CRITICAL ///< Still below a low watermark after reclaiming: free what you can.
+    };
+
+    /**
+     * @brief Pressure callback; may free VM objects and system heap, must not call poll().
+     * @param level Pressure level.
+     * @param ctx Context given to add_pressure_callback().
+     */
+    typedef void (*PressureCallback)(PressureLevel level, void* ctx);
+
+    /**
+     * @brief Configure reclamation watermarks (0 disables a watermark).
+     * @param low_frames Free frames (set_frame_limit() minus resident pages) below which there is pressure.
+     * @param high_frames Free frames that reclamation restores.
+     * @param low_heap Free system heap bytes (vm_free_heap()) below which there is pressure.
+     * @param high_heap Free system heap bytes that reclamation restores.
+     * @return False if a high watermark is below its low watermark, or a frame watermark is not
+     *         below the frame limit (nothing changed).
+     *
+     * @details Frame watermarks need a frame limit; if the limit is lowered later, they are
+     * capped at the limit minus one frame. When the frame limit forces an eviction,
+     * the pager evicts down to high_frames in one batch instead of one page per load. poll()
+     * reclaims ahead of demand and notifies pressure callbacks.
+     *
+     * @note This is part of the minimal public API that user code may call.
+     */
+    bool set_watermarks(size_t low_frames, size_t high_frames, size_t low_heap = 0, size_t high_heap = 0) {
+        if ((high_frames && high_frames < low_frames) || (high_heap && high_heap < low_heap)) return false;
+        if (frame_limit && (low_frames >= frame_limit || high_frames >= frame_limit)) return false;
+        wm_low_frames = low_frames;
+        wm_high_frames = high_frames ? high_frames : low_frames;
+        wm_low_heap = low_heap;
+        wm_high_heap = high_heap ? high_heap : low_heap;
+        return true;
+    }
+
+    /**
+     * @brief Frames that can be loaded without eviction.
+     * @return Frame limit minus resident pages, or SIZE_MAX without a frame limit.
+     *
+     * @note Minimal public accessor; safe for user code.
+     */
+    size_t free_frames() const {
+        if (!frame_limit) return std::numeric_limits<size_t>::max();
+        const size_t used = resident_frames();
+        return used < frame_limit ? frame_limit - used : 0;
+    }
+
+    /**
+     * @brief Check the low watermarks.
+     * @return True if free frames or free system heap are below their low watermark.
+     *
+     * @note Minimal public accessor; safe for user code.
+     */
+    bool under_pressure() const {
+        return (wm_low_frames && frame_limit && free_frames() < frame_watermark(wm_low_frames)) ||
+               (wm_low_heap && vm_free_heap() < wm_low_heap);
+    }
+
+    /**
+     * @brief Evict LRU pages until the high watermarks hold.
+     * @param max_pages Maximum evictions in this call (bounds the I/O per step).
+     * @return Pages evicted.
+     *
+     * @note This is part of the minimal public API that user code may call.
+     */
+    size_t reclaim(size_t max_pages = 4) {
+        if (!started) return 0;
+        size_t evicted = 0;
+        while (evicted < max_pages && below_high(0) && evict_one_page(TRACE_REASON_RECLAIM)) ++evicted;
+        return evicted;
+    }
+
+    /**
+     * @brief Background reclamation step: call from loop() or a low-priority task.
+     * @param max_pages Maximum evictions in this call.
+     * @return Pages evicted.
+     *
+     * @details Under pressure, notifies the callbacks with PRESSURE_LOW, reclaims up to max_pages
+     * toward the high watermarks, and notifies PRESSURE_CRITICAL if a low watermark still fails
+     * (e.g. the remaining resident pages are pinned). Without pressure it does nothing.
+     *
+     * @note This is part of the minimal public API that user code may call.
+     */
+    size_t poll(size_t max_pages = 4) {
+        if (!started || in_poll || !under_pressure()) return 0;
+        in_poll = true;
+        notify_pressure(PRESSURE_LOW);
+        const size_t evicted = reclaim(max_pages);
+        if (under_pressure()) notify_pressure(PRESSURE_CRITICAL);
+        in_poll = false;
+        return evicted;
+    }
+
+    /**
+     * @brief Register a memory-pressure callback (called from poll()).
+     * @param cb Callback.
+     * @param ctx Passed back to cb (e.g. the cache object).
+     * @return False if all VM_PRESSURE_CALLBACKS slots are taken.
+     *
+     * @note This is part of the minimal public API that user code may call.
+     */
+    bool add_pressure_callback(PressureCallback cb, void* ctx = nullptr) {
+        if (!cb) return false;
+        for (size_t i = 0; i < PRESSURE_SLOTS; ++i) {
+            if (pressure_cbs[i].cb) continue;
+            pressure_cbs[i].cb = cb;
+            pressure_cbs[i].ctx = ctx;
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Unregister a callback added with the same cb and ctx.
+     * @return True if it was registered.
+     *
+     * @note This is part of the minimal public API that user code may call.
+     */
+    bool remove_pressure_callback(PressureCallback cb, void* ctx = nullptr) {
+        for (size_t i = 0; i < PRESSURE_SLOTS; ++i) {
+            if (pressure_cbs[i].cb != cb || pressure_cbs[i].ctx != ctx) continue;
+            pressure_cbs[i].cb = nullptr;
+            pressure_cbs[i].ctx = nullptr;
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @struct SwapLogStats
+     * @brief State and counters of the log-structured swap (VM_SWAP_LOG).
+     */
+    struct SwapLogStats {
+        uint32_t segments = 0;         ///< Log segments in the swap area.
+        uint32_t segment_pages = 0;    ///< Pages per segment.
+        uint32_t free_segments = 0;    ///< Segments without live pages (excluding the one being filled).
+        uint32_t live_pages = 0;       ///< Pages whose current copy is in the log.
+        uint32_t appended_pages = 0;   ///< Pages appended by write-backs.
+        uint32_t cleaned_segments = 0; ///< Segments emptied by the cleaner.
+        uint32_t moved_pages = 0;      ///< Live pages the cleaner copied to the log head.
+        uint32_t dropped_pages = 0;    ///< Copies the cleaner dropped because RAM held newer (dirty) data.
+    };
+
+    /**
+     * @brief Read the log-structured swap state.
+     * @param out Output statistics.
+     * @return False if VM_SWAP_LOG is 0.
+     *
+     * @details Write amplification is (appended_pages + moved_pages) / appended_pages.
+     *
+     * @note Minimal public accessor; safe for user code.
+     */
+    bool swap_log_stats(SwapLogStats& out) const {
+        if (!SWAP_LOG) return false;
+        out = log_stats;
+        out.segments = (uint32_t)LOG_SEGS;
+        out.segment_pages = (uint32_t)LOG_SEG_PAGES;
+        out.free_segments = (uint32_t)log_free_segments();
+        out.live_pages = 0;
+        for (size_t g = 0; g < LOG_SEGS; ++g) out.live_pages += log_live[g];
+        return true;
+    }
+
+    /**
+     * @brief Background cleaner step of the log-structured swap (VM_SWAP_LOG).
+     * @param max_segments Maximum segments to clean in this call (bounds the I/O per step).
+     * @return Segments cleaned (0 if enough segments are free or nothing can be gained).
+     *
+     * @details Picks the closed segment with the fewest live pages, appends those pages at the
+     * log head (straight from RAM if resident) and frees the segment. It stops once
+     * VM_SWAP_LOG_SPARE_SEGMENTS segments are free. Call from loop() or a low-priority task
+     * so write-backs rarely have to clean synchronously.
+     *
+     * @note This is part of the minimal public API that user code may call.
+     */
+    size_t swap_log_clean(size_t max_segments = 1) {
+        if (!SWAP_LOG || !started) return 0;
+        size_t cleaned = 0;
+        while (cleaned < max_segments && log_free_segments() < VM_SWAP_LOG_SPARE_SEGMENTS && log_clean_one()) ++cleaned;
+        return cleaned;
+    }
+
+    /**
+     * @brief Register a named allocation tag for memory accounting.
+     * @param name Tag name (not copied; use a string literal or other static storage).
+     * @return Tag id (1..VM_TAG_COUNT), or 0 if accounting is disabled or all tags are taken.
+     *
+     * @details Allocations made while a tag is current (set_tag() or VMTagScope) are charged to
+     * it: small-heap blocks by size, dedicated pages and extents by page, and swap-ins and
+     * write-backs of those pages. Heap pages are shared, so their faults and write-backs go to
+     * the tag that last allocated or wrote a block in them. Tags survive end()/begin(); their
+     * counters are reset by begin().
+     *
+     * @note This is part of the minimal public API that user code may call.
+     */
+    uint8_t register_tag(const char* name) {
+        for (size_t t = 1; t < TAG_SLOTS; ++t) {
+            if (tag_table[t].name) continue;
+            tag_table[t].name = name;
+            return (uint8_t)t;
+        }
+        return 0;
+    }
+
+    /**
+     * @brief Make a tag current for subsequent allocations.
+     * @param tag Tag id from register_tag() (0 = untagged).
+     * @return Previously current tag (to restore later).
+     *
+     * @note This is part of the minimal public API that user code may call.
+     */
+    uint8_t set_tag(uint8_t tag) {
+        const uint8_t prev = current_tag;
+        current_tag = tag < TAG_SLOTS ? tag : 0;
+        return prev;
+    }
+
+    /**
+     * @brief Get the tag new allocations are charged to.
+     * @return Current tag id.
+     */
+    uint8_t get_tag() const { return current_tag; }
+
+    /**
+     * @brief Read the counters of one tag.
+     * @param tag Tag id (0 = untagged).
+     * @param out Output counters.
+     * @return False if accounting is disabled or the tag does not exist.
+     */
+    bool tag_stats(uint8_t tag, TagStats& out) const {
+        if (TAG_COUNT == 0 || tag >= TAG_SLOTS || (tag && !tag_table[tag].name)) return false;
+        out = tag_table[tag];
+        if (!out.name) out.name = "untagged";
+        return true;
+    }
+
+    /**
+     * @brief Print a per-tag memory accounting table.
+     * @tparam Out Anything with print(const char*), e.g. Serial.
+     * @param out Output sink.
+     *
+     * @note This is part of the minimal public API that user code may call.
+     */
+    template<typename Out>
+    void report(Out& out) const {
+        char line[96];
+        snprintf(line, sizeof(line), "%-16s %10s %7s %6s %8s %10s\n",
+                 "tag", "heap_bytes", "blocks", "pages", "faults", "writebacks");
+        out.print(line);
+        TagStats ts;
+        for (size_t t = 0; t < TAG_SLOTS; ++t) {
+            if (!tag_stats((uint8_t)t, ts)) continue;
+            snprintf(line, sizeof(line), "%-16.16s %10lu %7lu %6lu %8lu %10lu\n", ts.name,
+                     (unsigned long)ts.heap_bytes, (unsigned long)ts.heap_blocks, (unsigned long)ts.pages,
+                     (unsigned long)ts.faults, (unsigned long)ts.writebacks);
+            out.print(line);
+        }
+    }
+
+#if VM_HAVE_FS
+    /**
+     * @brief Start recording page accesses to a file for offline replay (VM_ACCESS_LOG > 0).
+     * @param filesystem Filesystem for the log (may be the swap filesystem).
+     * @param path Log file path (truncated).
+     * @return False if capture is compiled out or the file cannot be opened.
+     *
+     * @details The log is a 16-byte header (magic 'VMAT', version, page size, page count)
+     * followed by one native-endian (little-endian on ESP32) uint32 per record: bits 31..30 are the kind (0 read,
+     * 1 write, 2 page freed) and bits 29..0 the byte address page * page_size + offset.
+     * Records are buffered in RAM (VM_ACCESS_LOG entries) and appended when the buffer fills.
+     * Replay the file on a host with extras/vm_replay to compare frame counts, page sizes and
+     * eviction policies.
+     *
+     * @note This is part of the minimal public API that user code may call.
+     */
+    bool access_log_begin(fs::FS& filesystem, const char* path) {
+        if (!ACCESS_LOG_SLOTS || !started) return false;
+        access_log_end();
+        filesystem.remove(path);
+        access_log_file = filesystem.open(path, FILE_WRITE);
+        if (!access_log_file) return false;
+        const uint32_t header[4] = {ACCESS_LOG_MAGIC, ACCESS_LOG_VERSION, (uint32_t)page_size, (uint32_t)page_count};
+        access_log_file.write(reinterpret_cast<const uint8_t*>(header), sizeof(header));
+        access_log_fill = 0;
+        access_log_on = true;
+        return true;
+    }
+#endif
+
+    /**
+     * @brief Flush buffered records and close the access log.
+     *
+     * @note This is part of the minimal public API that user code may call.
+     */
+    void access_log_end() {
+        if (!access_log_on) return;
+        access_log_flush();
+#if VM_HAVE_FS
+        access_log_file.close();
+#endif
+        access_log_on = false;
+    }
+
+    /**
+     * @brief Analyze one small-heap page by walking its block list.
+     * @param idx Page index.
+     * @param out Output occupancy, free-block histogram and ASCII map.
+     * @return False if idx is not an allocated heap page or it cannot be loaded.
+     *
+     * @details The page is faulted in if it is swapped out (a diagnostic read; it counts as a
+     * fault in statistics and traces). Values are exact, unlike the running totals in the header.
+     *
+     * @note This is part of the minimal public API that user code may call.
+     */
+    bool heap_page_info(int idx, HeapPageInfo& out) {
+        if (!valid_index(idx) || !pages[idx].allocated || !pages[idx].is_heap) return false;
+        if (!ensure_heap_header(idx)) return false;
+        const uint8_t* base = pages[idx].ram_addr;
+        out = HeapPageInfo();
+        out.page = idx;
+        out.header_bytes = (uint32_t)HH_SIZE;
+
+        constexpr size_t kCells = sizeof(out.map) - 1;
+        const size_t cell = (page_size + kCells - 1) / kCells;
+        uint16_t cell_used[kCells] = {};
+        uint16_t cell_free[kCells] = {};
+        bool cell_pinned[kCells] = {};
+        // Credit [from, to) to the map cells it covers.
+        auto paint = [&](size_t from, size_t to, bool used, bool pinned) {
+            while (from < to) {
+                const size_t c = from / cell;
+                const size_t end = std::min(to, (c + 1) * cell);
+                if (used) cell_used[c] = (uint16_t)(cell_used[c] + (end - from));
+                else cell_free[c] = (uint16_t)(cell_free[c] + (end - from));
+                if (pinned) cell_pinned[c] = true;
+                from = end;
+            }
+        };
+        paint(0, HH_SIZE, true, true);
+
+        size_t off = HH_SIZE;
+        while (off + BH_SIZE <= page_size) {
+            const BlockHeader* bh = reinterpret_cast<const BlockHeader*>(base + off);
+            const size_t span = BH_SIZE + bh->size;
+            if (off + span > page_size) break; // corrupt header: stop rather than run off the page
+            out.header_bytes += (uint32_t)BH_SIZE;
+            if (bh->flags & 1) {
+                out.free_blocks++;
+                out.free_bytes += bh->size;
+                if (bh->size > out.largest_free) out.largest_free = bh->size;
+                size_t bucket = 0;
+                while (bucket < 7 && bh->size >= (16u << bucket)) ++bucket;
+                out.free_hist[bucket]++;
+                paint(off, off + BH_SIZE, true, false);
+                paint(off + BH_SIZE, off + span, false, false);
+            } else {
+                const bool pinned = bh->reserved == 0;
+                out.live_blocks++;
+                if (pinned) out.pinned_blocks++;
+                out.live_bytes += bh->size;
+                paint(off, off + span, true, pinned);
+            }
+            off += span;
+        }
+        if (off < page_size) paint(off, page_size, false, false); // unreachable tail
+        out.fragmentation = out.free_bytes ? 1.0f - (float)out.largest_free / (float)out.free_bytes : 0.0f;
+        for (size_t c = 0; c < kCells; ++c) {
+            if (cell_used[c] && cell_free[c]) out.map[c] = ':';
+            else if (cell_free[c]) out.map[c] = '.';
+            else if (cell_used[c]) out.map[c] = cell_pinned[c] ? '#' : '=';
+            else out.map[c] = ' ';
+        }
+        return true;
+    }
+
+    /**
+     * @brief Print the occupancy and fragmentation of every heap page, optionally with its map.
+     * @tparam Out Anything with print(const char*), e.g. Serial.
+     * @param out Output sink.
+     * @param with_map Also print the ASCII map of each page.
+     *
+     * @details Faults in heap pages that are swapped out (see heap_page_info()).
+     *
+     * @note This is part of the minimal public API that user code may call.
+     */
+    template<typename Out>
+    void heap_report(Out& out, bool with_map = true) {
+        char line[160];
+        out.print("page live pinned  live_B free free_B largest  hdr_B  frag  free<16,32,64,..,1K,>1K\n");
+        HeapPageInfo hi;
+        for (size_t i = 0; i < page_count; ++i) {
+            if (!heap_page_info((int)i, hi)) continue;
+            snprintf(line, sizeof(line), "%4d %4u %6u %7lu %4u %6lu %7lu %6lu %4.0f%%  %u,%u,%u,%u,%u,%u,%u,%u\n",
+                     hi.page, hi.live_blocks, hi.pinned_blocks, (unsigned long)hi.live_bytes, hi.free_blocks,
+                     (unsigned long)hi.free_bytes, (unsigned long)hi.largest_free, (unsigned long)hi.header_bytes,
+                     100.0 * hi.fragmentation, hi.free_hist[0], hi.free_hist[1], hi.free_hist[2], hi.free_hist[3],
+                     hi.free_hist[4], hi.free_hist[5], hi.free_hist[6], hi.free_hist[7]);
+            out.print(line);
+            if (with_map) {
+                snprintf(line, sizeof(line), "     [%s]\n", hi.map);
+                out.print(line);
+            }
+        }
+    }
+
+    /**
+     * @brief Number of events currently held by the trace ring (oldest ones are overwritten).
+     * @return Event count (always 0 when VM_TRACE_EVENTS is 0).
+     */
+    size_t trace_count() const {
+        return trace_total < TRACE_EVENTS ? trace_total : TRACE_EVENTS;
+    }
+
+    /**
+     * @brief Number of events lost because the ring wrapped.
+     * @return Dropped event count.
+     */
+    uint32_t trace_dropped() const { return trace_total - (uint32_t)trace_count(); }
+
+    /**
+     * @brief Read one trace event.
+     * @param i Position, 0 = oldest event still held.
+     * @param out Output event.
+     * @return False if i >= trace_count().
+     */
+    bool trace_event(size_t i, TraceEvent& out) const {
+        const size_t n = trace_count();
+        if (i >= n) return false;
+        out = trace_ring[(trace_total - n + i) % TRACE_SLOTS];
+        return true;
+    }
+
+    /**
+     * @brief Discard all recorded events.
+     */
+    void trace_clear() { trace_total = 0; }
+
+    /**
+     * @brief Write the trace as Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev).
+     * @tparam Out Anything with print(const char*), e.g. Serial or an open fs::File.
+     * @param out Output sink.
+     *
+     * @details Paging events go to thread "paging", heap events to thread "heap"; each event is
+     * a complete ("X") slice with its page, argument and reason in args.
+     *
+     * @note This is part of the minimal public API that user code may call.
+     */
+    template<typename Out>
+    void export_chrome_trace(Out& out) const {
+        static const char* const names[] = {"swap_in", "swap_out", "evict", "heap_alloc", "heap_free"};
+        static const char* const reasons[] = {"", "ram_full", "reclaim"};
+        char line[160];
+        out.print("{\"traceEvents\":[\n"
+                  "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"paging\"}},\n"
+                  "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"heap\"}}");
+        TraceEvent e;
+        for (size_t i = 0; trace_event(i, e); ++i) {
+            if (e.type > TRACE_HEAP_FREE) continue;
+            snprintf(line, sizeof(line),
+                     ",\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%lu,\"dur\":%lu,\"pid\":1,\"tid\":%d,"
+                     "\"args\":{\"page\":%d,\"arg\":%lu,\"reason\":\"%s\"}}",
+                     names[e.type], (unsigned long)e.ts_us, (unsigned long)e.dur_us,
+                     e.type >= TRACE_HEAP_ALLOC ? 2 : 1, (int)e.page, (unsigned long)e.arg,
+                     e.reason <= TRACE_REASON_RECLAIM ? reasons[e.reason] : "");
+            out.print(line);
+        }
+        out.print("\n]}\n");
+    }
+
+    /**
+     * @brief Write the trace as Chrome trace-event JSON to a C stdio file (host builds, tests).
+     * @param f Open file.
+     */
+    void export_chrome_trace(FILE* f) const {
+        struct FilePrint {
+            FILE* f;
+            void print(const char* s) { fputs(s, f); }
+        } sink{f};
+        export_chrome_trace(sink);
+    }
+
+    /**
+     * @brief Number of page accesses sampled by the miss-ratio-curve estimator (VM_MRC).
+     * @return Sampled accesses since begin() or mrc_reset() (0 when VM_MRC is 0).
+     */
+    uint32_t mrc_samples() const { return mrc_sampled; }
+
+    /**
+     * @brief Estimated fault ratio with a given number of resident frames under LRU.
+     * @param frames Number of pages that fit in RAM (1..page count).
+     * @return Fraction of page accesses that would fault (0..1); 0 without samples.
+     *
+     * @details Built SHARDS-style: accesses to a hash-sampled subset of pages (rate 1/2^
+     * VM_MRC_SAMPLE_SHIFT) feed an LRU stack, the stack depth of each reuse (scaled by the
+     * sampling rate) is the reuse distance, and an access faults with 'frames' frames iff its
+     * distance is at least 'frames'. Distances are in pages: an extent counts with its length,
+     * both above a reused unit and for the frames the unit itself needs. First touches after a page is allocated are counted as
+     * accesses but not as faults, since new pages are created resident. Accesses are the
+     * pointer acquisitions that reach the page table; VMPtr hits on its cached frame are not seen.
+     *
+     * @note This is part of the minimal public API that user code may call.
+     */
+    float mrc_miss_ratio(size_t frames) const {
+        if (!MRC_ENABLED || mrc_sampled == 0) return 0.0f;
+        uint32_t misses = 0;
+        for (size_t d = frames; d <= page_count; ++d) misses += mrc_hist[d];
+        return (float)misses / (float)mrc_sampled;
+    }
+
+    /**
+     * @brief Smallest frame count whose estimated fault ratio is at or below a target.
+     * @param max_miss_ratio Acceptable fault ratio (e.g. 0.01).
+     * @return Working-set size in pages (page count if the target is never reached).
+     */
+    size_t mrc_working_set(float max_miss_ratio) const {
+        for (size_t f = 1; f < page_count; ++f)
+            if (mrc_miss_ratio(f) <= max_miss_ratio) return f;
+        return page_count;
+    }
+
+    /**
+     * @brief Print the estimated fault ratio for every frame count.
+     * @tparam Out Anything with print(const char*), e.g. Serial.
+     * @param out Output sink.
+     *
+     * @note This is part of the minimal public API that user code may call.
+     */
+    template<typename Out>
+    void mrc_report(Out& out) const {
+        char line[64];
+        snprintf(line, sizeof(line), "mrc: %lu sampled accesses\nframes  miss%%\n", (unsigned long)mrc_sampled);
+        out.print(line);
+        for (size_t f = 1; f <= page_count; ++f) {
+            snprintf(line, sizeof(line), "%6lu  %5.1f\n", (unsigned long)f, 100.0 * mrc_miss_ratio(f));
+            out.print(line);
+        }
+    }
+
+    /**
+     * @brief Restart miss-ratio-curve estimation (e.g. after boot, to measure steady state).
+     */
+    void mrc_reset() {
+        mrc_depth = 0;
+        mrc_sampled = 0;
+        for (size_t d = 0; d <= MRC_SLOTS; ++d) mrc_hist[d] = 0;
+    }
+
+    /**
+     * @brief Latency histogram of one operation (VM_LATENCY_STATS).
+     * @param op TRACE_SWAP_IN, TRACE_SWAP_OUT, TRACE_EVICT or TRACE_HEAP_ALLOC.
+     * @return Histogram in microseconds, or nullptr if latency stats are disabled or op is not timed.
+     *
+     * @details swap_in includes the evictions it triggers; evict includes the victim's write-back.
+     * swap_out only records calls that wrote the page back (clean pages need no I/O).
+     */
+    const VMLatencyHistogram* latency(TraceType op) const {
+        return (LATENCY_ENABLED && op < LATENCY_OPS) ? &latency_hist[op] : nullptr;
+    }
+
+    /**
+     * @brief Discard all latency samples.
+     */
+    void latency_reset() {
+        for (size_t i = 0; i < LATENCY_SLOTS; ++i) latency_hist[i].reset();
+    }
+
+    /**
+     * @brief Print count, p50, p99, p999 and max of every timed operation (microseconds).
+     * @tparam Out Anything with print(const char*), e.g. Serial.
+     * @param out Output sink.
+     *
+     * @note This is part of the minimal public API that user code may call.
+     */
+    template<typename Out>
+    void latency_report(Out& out) const {
+        static const char* const names[] = {"swap_in", "swap_out", "evict", "heap_alloc"};
+        char line[96];
+        out.print("op              count      p50      p99     p999      max (us)\n");
+        for (size_t i = 0; i < LATENCY_OPS; ++i) {
+            const VMLatencyHistogram* h = latency((TraceType)i);
+            if (!h) return;
+            snprintf(line, sizeof(line), "%-10s %10lu %8lu %8lu %8lu %8lu\n", names[i], (unsigned long)h->count(),
+                     (unsigned long)h->percentile(0.5f), (unsigned long)h->percentile(0.99f),
+                     (unsigned long)h->percentile(0.999f), (unsigned long)h->max());
+            out.print(line);
+        }
+    }
+
+    /**
+     * @brief Incrementally compact the small-block heap.
+     * @param max_moves Maximum number of blocks to relocate in this call (bounds the work per step).
+     * @return Number of blocks moved (0 when nothing could be packed further).
+     *
+     * @details Only blocks allocated through the handle table (VM_HANDLE_COUNT > 0) can move.
+     * Each step evacuates live blocks from the emptiest heap page into fuller ones; if none fits,
+     * it instead slides the live blocks of one fragmented heap page together so its free space
+     * becomes a single block. Call repeatedly (e.g. from loop()) until it returns 0. Containers
+     * and VMPtr resolve handles on every access; raw pointers obtained earlier (e.g.
+     * VMVector::data()) are invalidated.
+     *
+     * @note This is part of the minimal public API that user code may call.
+     */
+    size_t compact_step(size_t max_moves = 4) {
+        if (!started || HANDLE_COUNT == 0 || max_moves == 0) return 0;
+
+        // Sources: heap pages from the emptiest down; targets: strictly fuller heap pages.
+        bool tried[VM_PAGE_COUNT] = {false};
+        for (;;) {
+            int src = -1;
+            uint32_t src_free = 0;
+            for (size_t i = 0; i < page_count; ++i) {
+                if (tried[i] || !pages[i].allocated || !pages[i].is_heap) continue;
+                if (pages[i].heap_live == 0) continue; // empty page: nothing to move
+                if (pages[i].pin_count) continue;      // locked: addresses must stay put
+                const uint32_t tf = pages[i].heap_total_free;
+                if (src < 0 || tf > src_free) { src = (int)i; src_free = tf; }
+            }
+            if (src < 0) break;
+            tried[src] = true;
+
+            size_t moved = 0;
+            size_t off = HH_SIZE;
+            while (off + BH_SIZE <= page_size && moved < max_moves) {
+                // The last move may have released src (heap_free() of its final live block).
+                if (!pages[src].allocated || !pages[src].is_heap) return moved;
+                if (!ensure_heap_header(src)) return moved;
+                BlockHeader* bh = reinterpret_cast<BlockHeader*>(pages[src].ram_addr + off);
+                const size_t next = off + BH_SIZE + bh->size;
+                if ((bh->flags & 1) == 0 && bh->reserved != 0 && move_block(src, off + BH_SIZE, src_free))
+                    ++moved;
+                off = next;
+            }
+            if (moved && pages[src].allocated) bump_generation(src); // cached frame pointers into src may now be stale
+            if (moved) return moved;
+        }
+
+        // Nothing fits anywhere: coalesce the free space of the most promising fragmented page.
+        int frag = -1;
+        uint32_t frag_free = 0;
+        for (size_t i = 0; i < page_count; ++i) {
+            if (!pages[i].allocated || !pages[i].is_heap || pages[i].pin_count) continue;
+            const VMPage& pg = pages[i];
+            if (pg.heap_largest_free == pg.heap_total_free) continue; // at most one free block
+            if (frag < 0 || pg.heap_total_free > frag_free) { frag = (int)i; frag_free = pg.heap_total_free; }
+        }
+        return frag < 0 ? 0 : slide_heap_page(frag);
+    }
+
 private:
     VMManager() : started(false), access_tick(0) {
         default_alloc_options.zero_on_alloc = true;
@@ -240,23 +1822,304 @@ private:
     // Grant privileged access to VM friends only.
     template<typename T> friend class ::VMPtr;
     template<typename T> friend class ::VMVector;
+    template<typename T> friend class ::VMPackedVector;
     template<typename T, size_t N> friend class ::VMArray;
     friend class ::VMString;
+    friend class ::VMLockSet;
+    friend class ::VMNoFaultScope;
     
-    // Friend declaration for make_vm helper function
+    // Friend declarations for make_vm helper functions
     template<typename T, typename... Args>
     friend VMPtr<T> make_vm(Args&&... args);
+    template<typename T>
+    friend VMPtr<T> make_vm_array(size_t n);
+    template<typename T>
+    friend void destroy_vm_array(VMPtr<T>& p, size_t n);
+    template<typename T, typename... Args>
+    friend void make_vm_batch(VMPtr<T>* out, size_t n, const Args&... args);
+    template<typename T>
+    friend void destroy_vm_batch(VMPtr<T>* ptrs, size_t n);
 
     // -------------------- Private state (hidden from end users) --------------------
     VMPage pages[VM_PAGE_COUNT]; ///< Page table.
-    fs::File swap_read;              ///< Read-only handle for the swap file (portable alternative to "r+").
-    fs::File swap_write;             ///< Write handle for the swap file (kept open to avoid repeated truncation).
-    fs::FS* fs = nullptr;        ///< Filesystem pointer.
+    VMSwapBackend* backend = nullptr; ///< Swap storage of the current session.
+#if VM_HAVE_FS
+    VMFileSwapBackend file_backend;   ///< Backend used by begin(fs, path).
+#endif
     size_t page_size = VM_PAGE_SIZE; ///< Current page size (constant).
     size_t page_count = VM_PAGE_COUNT; ///< Number of pages (constant).
 
+    size_t frame_limit = 0;          ///< Resident page cap (0 = unlimited).
+    uint16_t no_fault_depth = 0;     ///< Active VMNoFaultScope nesting.
+    bool no_fault_strict = false;    ///< Innermost scope refuses blocking I/O (else only counts it).
+    uint32_t no_fault_count = 0;     ///< Blocking I/O attempts inside no-fault scopes.
+
+    // -------------------- Log-structured swap --------------------
+    static constexpr bool   SWAP_LOG      = VM_SWAP_LOG != 0;
+    static constexpr size_t LOG_SEG_PAGES = VM_SWAP_LOG_SEGMENT_PAGES;
+    /// Twice the segments perfect packing needs: with first-fit placement at most one segment
+    /// is half full or less, whatever mix of extent lengths is stored.
+    static constexpr size_t LOG_SEGS      = SWAP_LOG ? 2 * ((VM_PAGE_COUNT + LOG_SEG_PAGES - 1) / LOG_SEG_PAGES) + VM_SWAP_LOG_SPARE_SEGMENTS : 1;
+    static constexpr size_t LOG_SLOTS     = SWAP_LOG ? LOG_SEGS * LOG_SEG_PAGES : 1;
+    static_assert(!SWAP_LOG || (LOG_SEG_PAGES > 0 && VM_SWAP_LOG_SPARE_SEGMENTS >= 2),
+                  "VM_SWAP_LOG needs VM_SWAP_LOG_SEGMENT_PAGES > 0 and VM_SWAP_LOG_SPARE_SEGMENTS >= 2");
+    static_assert(!SWAP_LOG || VM_PAGE_COUNT < 32768, "VM_SWAP_LOG supports up to 32767 pages");
+
+    int16_t  log_owner[LOG_SLOTS];   ///< Page whose current copy occupies the slot (-1 = free or stale).
+    uint16_t log_live[LOG_SEGS];     ///< Live slots per segment.
+    uint16_t log_fill[LOG_SEGS];     ///< Slots written since the segment was last free (next slot to use).
+    int      log_open = -1;          ///< Segment being appended to (-1 = none).
+    int      log_victim = -1;        ///< Segment being cleaned (never a placement target).
+    SwapLogStats log_stats;          ///< Counters (see swap_log_stats()).
+
+    /// Swap area size: one slot per page, or the whole log.
+    size_t swap_bytes() const { return (SWAP_LOG ? LOG_SLOTS : page_count) * page_size; }
+
+    /// Forget all log contents (new session).
+    void log_reset() {
+        for (size_t i = 0; i < LOG_SLOTS; ++i) log_owner[i] = -1;
+        for (size_t g = 0; g < LOG_SEGS; ++g) log_live[g] = log_fill[g] = 0;
+        log_open = -1;
+        log_victim = -1;
+        log_stats = SwapLogStats();
+    }
+
+    /**
+     * @brief Check whether a unit's current content is in the log.
+     * @param head Head page index.
+     * @return True if the slot at its swap_offset belongs to it (always false outside log mode).
+     */
+    bool log_has_copy(int head) const {
+        return SWAP_LOG && log_owner[pages[head].swap_offset / page_size] == head;
+    }
+
+    /// Count segments with no live pages, excluding the one being filled.
+    size_t log_free_segments() const {
+        size_t n = 0;
+        for (size_t g = 0; g < LOG_SEGS; ++g)
+            if ((int)g != log_open && log_live[g] == 0) ++n;
+        return n;
+    }
+
+    /**
+     * @brief Mark a unit's log copy stale.
+     * @param head Head page index (no-op if it has no copy).
+     */
+    void log_release(int head) {
+        if (!log_has_copy(head)) return;
+        const size_t first = pages[head].swap_offset / page_size;
+        for (size_t k = 0; k < unit_len(head); ++k) {
+            log_owner[first + k] = -1;
+            log_live[(first + k) / LOG_SEG_PAGES]--;
+        }
+    }
+
+    /**
+     * @brief Record that a unit's current copy starts at slot first.
+     * @param head Head page index.
+     * @param first First slot (the unit's slots are consecutive, in one segment).
+     */
+    void log_assign(int head, size_t first) {
+        for (size_t k = 0; k < unit_len(head); ++k) {
+            pages[head + k].swap_offset = (first + k) * page_size;
+            log_owner[first + k] = (int16_t)(head + k);
+            log_live[(first + k) / LOG_SEG_PAGES]++;
+        }
+    }
+
+    /**
+     * @brief Take n slots at the end of segment g and make it the append segment.
+     * @param g Segment with room for n more slots (a segment without live slots starts over).
+     * @param n Slots.
+     * @return First slot.
+     */
+    long log_append(int g, size_t n) {
+        if (g != log_open && log_live[g] == 0) log_fill[g] = 0;
+        log_open = g;
+        const long slot = (long)((size_t)g * LOG_SEG_PAGES + log_fill[g]);
+        log_fill[g] += (uint16_t)n;
+        return slot;
+    }
+
+    /**
+     * @brief Place n slots without cleaning.
+     * @param n Slots (at most one segment).
+     * @param fresh True to prefer a free segment over the tails of used ones.
+     * @return First slot, or -1 if no segment has room.
+     *
+     * @details Order: the append segment (sequential), then, while free segments are
+     * plentiful, a free one (still sequential); otherwise the first used segment whose tail
+     * fits (first fit, so extents that did not fit a tail leave it to smaller units).
+     */
+    long log_fit(size_t n, bool fresh) {
+        if (log_open >= 0 && log_open != log_victim && log_fill[log_open] + n <= LOG_SEG_PAGES)
+            return log_append(log_open, n);
+        for (int pass = fresh ? 0 : 1; pass < 2; ++pass) {
+            for (size_t g = 0; g < LOG_SEGS; ++g) {
+                if ((int)g == log_open || (int)g == log_victim) continue;
+                if (pass == 0 && log_live[g] == 0) return log_append((int)g, n);
+                if (pass == 1 && log_live[g] != 0 && log_fill[g] + n <= LOG_SEG_PAGES) return log_append((int)g, n);
+            }
+        }
+        return -1;
+    }
+
+    /**
+     * @brief Reserve n consecutive slots in the log.
+     * @param n Slots (at most one segment).
+     * @param cleaning True when called by the cleaner, which may use the last free segment.
+     * @return First slot, or -1 if the log is full.
+     *
+     * @details See log_fit() for the placement order. A write-back that finds no room cleans
+     * synchronously while at most one segment is free, then takes any free segment.
+     */
+    long log_reserve(size_t n, bool cleaning) {
+        if (n == 0 || n > LOG_SEG_PAGES) return -1;
+        long slot = log_fit(n, log_free_segments() > VM_SWAP_LOG_SPARE_SEGMENTS);
+        if (slot >= 0) return slot;
+        if (!cleaning) {
+            for (size_t tries = 0; tries < LOG_SEGS && log_free_segments() <= 1 && log_clean_one(); ++tries) {}
+            slot = log_fit(n, false); // cleaning may have left room in a tail
+            if (slot >= 0) return slot;
+        }
+        for (size_t g = 0; g < LOG_SEGS; ++g)
+            if ((int)g != log_open && (int)g != log_victim && log_live[g] == 0) return log_append((int)g, n);
+        return -1;
+    }
+
+    /**
+     * @brief Append a resident unit's RAM content at the log head.
+     * @param head Head page index.
+     * @param written Output bytes written.
+     * @return False if no log space could be found (the unit keeps its RAM and old copy).
+     */
+    bool log_write_unit(int head, size_t& written) {
+        const size_t n = unit_len(head);
+        const long slot = log_reserve(n, false);
+        if (slot < 0) return false;
+        written = backend->write((size_t)slot * page_size, pages[head].ram_addr, n * page_size);
+        log_release(head);
+        log_assign(head, (size_t)slot);
+        log_stats.appended_pages += (uint32_t)n;
+        return true;
+    }
+
+    /**
+     * @brief Clean the segment with stale slots that has the fewest live pages.
+     * @return True if a segment was emptied.
+     *
+     * @details Each live unit is placed again (see log_reserve()): from RAM if resident and
+     * clean, through a page-sized bounce buffer otherwise. A resident dirty unit's copy is
+     * just dropped, since its next write-back appends a fresh one anyway. Segments without
+     * stale slots are skipped: moving their units would only recreate the same layout.
+     */
+    bool log_clean_one() {
+        int victim = -1;
+        for (size_t g = 0; g < LOG_SEGS; ++g) {
+            if ((int)g == log_open || log_live[g] == 0 || log_live[g] >= log_fill[g]) continue;
+            if (victim < 0 || log_live[g] < log_live[victim]) victim = (int)g;
+        }
+        if (victim < 0) return false;
+        log_victim = victim;
+        const size_t first = (size_t)victim * LOG_SEG_PAGES;
+        for (size_t s = first; s < first + LOG_SEG_PAGES; ++s) {
+            if (log_owner[s] < 0) continue;
+            const int head = unit_head(log_owner[s]);
+            const size_t n = unit_len(head);
+            VMPage& pg = pages[head];
+            const bool resident = pg.in_ram && pg.ram_addr;
+            bool dirty = false;
+            for (size_t k = 0; k < n; ++k) dirty = dirty || pages[head + k].dirty;
+            if (resident && dirty) {
+                log_release(head);
+                log_stats.dropped_pages += (uint32_t)n;
+                continue;
+            }
+            const long dst = log_reserve(n, true);
+            if (dst < 0) {
+                log_victim = -1;
+                return false;
+            }
+            if (resident) {
+                backend->write((size_t)dst * page_size, pg.ram_addr, n * page_size);
+            } else {
+                uint8_t buf[VM_PAGE_SIZE];
+                for (size_t k = 0; k < n; ++k) {
+                    backend->read(pages[head + k].swap_offset, buf, page_size);
+                    backend->write(((size_t)dst + k) * page_size, buf, page_size);
+                }
+            }
+            log_release(head);
+            log_assign(head, (size_t)dst);
+            log_stats.moved_pages += (uint32_t)n;
+        }
+        backend->flush();
+        log_victim = -1;
+        log_stats.cleaned_segments++;
+        return true;
+    }
+
+    /**
+     * @brief Allocation options as applied in log mode.
+     * @param opts Requested options.
+     * @return opts, with reuse_swap_data turned into zero_on_alloc when VM_SWAP_LOG is set
+     *         (the log keeps no per-page home slot to reuse).
+     */
+    static AllocOptions log_alloc_options(const AllocOptions& opts) {
+        AllocOptions o = opts;
+        if (SWAP_LOG && o.reuse_swap_data) {
+            o.reuse_swap_data = false;
+            o.zero_on_alloc = true;
+        }
+        return o;
+    }
+
+    // -------------------- Memory pressure --------------------
+    static constexpr size_t PRESSURE_SLOTS = VM_PRESSURE_CALLBACKS;
+
+    /** @brief Registered pressure callback. */
+    struct PressureSlot {
+        PressureCallback cb = nullptr;
+        void* ctx = nullptr;
+    };
+
+    size_t wm_low_frames = 0;        ///< Low free-frame watermark (0 = off).
+    size_t wm_high_frames = 0;       ///< Free frames restored by reclamation.
+    size_t wm_low_heap = 0;          ///< Low free-heap watermark in bytes (0 = off).
+    size_t wm_high_heap = 0;         ///< Free heap restored by reclamation.
+    bool in_poll = false;            ///< poll() is running (callbacks must not re-enter it).
+    PressureSlot pressure_cbs[PRESSURE_SLOTS ? PRESSURE_SLOTS : 1]; ///< Registered callbacks.
+
+    /**
+     * @brief Check the high watermarks.
+     * @param reserve Frames about to be taken by the caller (its buffer is already allocated).
+     * @return True if free frames or free heap are below their high watermark.
+     */
+    bool below_high(size_t reserve) const {
+        return (wm_high_frames && frame_limit && free_frames() < frame_watermark(wm_high_frames) + reserve) ||
+               (wm_high_heap && vm_free_heap() < wm_high_heap);
+    }
+
+    /**
+     * @brief Frame watermark capped below the frame limit (a watermark at or above it would
+     *        evict every page on each load).
+     * @param wm Configured watermark.
+     * @return Effective watermark (frame_limit must be non-zero).
+     */
+    size_t frame_watermark(size_t wm) const { return std::min(wm, frame_limit - 1); }
+
+    /**
+     * @brief Call every registered pressure callback.
+     * @param level Pressure level.
+     */
+    void notify_pressure(PressureLevel level) {
+        for (size_t i = 0; i < PRESSURE_SLOTS; ++i)
+            if (pressure_cbs[i].cb) pressure_cbs[i].cb(level, pressure_cbs[i].ctx);
+    }
+
     bool started;                    ///< True if manager initialized.
     uint64_t access_tick;            ///< Global access counter.
+    uint32_t generation_tick = 0;    ///< Source of VMPage::generation values (unique across pages).
     AllocOptions default_alloc_options; ///< Default allocation options.
 
     // -------------------- Small-block heap (shared pages) --------------------
@@ -265,10 +2128,10 @@ private:
      */
     struct HeapHeader {
         uint32_t magic;       ///< Magic 'VMHP'.
-        uint16_t version;     ///< Format version (1).
-        uint16_t reserved;    ///< Reserved.
+        uint16_t version;     ///< Format version (2).
+        uint16_t live;        ///< Number of allocated blocks (0 = page can be released).
         uint32_t first_free;  ///< Offset to first free block header (0 if none).
-        uint32_t total_free;  ///< Total free bytes in payload area (approximate).
+        uint32_t total_free;  ///< Total free bytes in payload area (see heap_page_info() for an exact walk).
     };
 
     /**
@@ -280,14 +2143,238 @@ private:
         uint32_t size;        ///< Payload size in bytes (rounded up to alignment).
         uint32_t next_free;   ///< Offset to next free block header (0 if none); valid only when free.
         uint16_t flags;       ///< Bit0 = 1 -> free, 0 -> used.
-        uint16_t reserved;    ///< Reserved/padding.
+        uint16_t reserved;    ///< Handle id + 1 of a relocatable block (0 = pinned).
+        uint16_t tag;         ///< Accounting tag of a used block (VM_TAG_COUNT > 0).
+        uint16_t pad;         ///< Padding.
     };
 
     static constexpr uint32_t HEAP_MAGIC = 0x564D4850u; // 'VMHP'
-    static constexpr uint16_t HEAP_VERSION = 1;
+    static constexpr uint16_t HEAP_VERSION = 2;
     static constexpr size_t   HEAP_ALIGN   = 8;         // 8-byte alignment for payloads
     static constexpr size_t   HH_SIZE      = ((sizeof(HeapHeader) + (HEAP_ALIGN - 1)) & ~(HEAP_ALIGN - 1));
     static constexpr size_t   BH_SIZE      = ((sizeof(BlockHeader) + (HEAP_ALIGN - 1)) & ~(HEAP_ALIGN - 1));
+    static constexpr size_t   HEAP_MAX_PAYLOAD = VM_PAGE_SIZE - HH_SIZE - BH_SIZE; ///< Compile-time heap_max_payload().
+    static constexpr size_t   HEAP_RESERVE_PAGES = VM_HEAP_RESERVE_PAGES; ///< Empty heap pages kept for reuse.
+
+    // -------------------- Handle table (relocatable small blocks) --------------------
+    /**
+     * @brief Current location of a relocatable small block.
+     *
+     * @details With VM_HANDLE_COUNT > 0, small_alloc() returns the pseudo page index
+     * page_count + handle and payload offset 0; the small_* accessors translate it through this
+     * table, and the block header's reserved field stores handle + 1 so compact_step() can update
+     * the entry when it moves the block.
+     */
+    struct HeapHandle {
+        int page;        ///< Physical page index (-1 = slot unused).
+        uint32_t offset; ///< Physical payload offset.
+    };
+
+    static constexpr size_t HANDLE_COUNT = VM_HANDLE_COUNT;                      ///< Usable handles.
+    static constexpr size_t HANDLE_SLOTS = VM_HANDLE_COUNT ? VM_HANDLE_COUNT : 1; ///< Array size (never zero).
+    static_assert(VM_HANDLE_COUNT < 0xFFFF, "VM_HANDLE_COUNT must fit BlockHeader::reserved");
+
+    HeapHandle handles[HANDLE_SLOTS]; ///< Handle table.
+
+    // -------------------- Allocation tags (memory accounting) --------------------
+    static constexpr size_t TAG_COUNT = VM_TAG_COUNT;     ///< User tags (ids 1..TAG_COUNT).
+    static constexpr size_t TAG_SLOTS = VM_TAG_COUNT + 1; ///< Tag 0 (untagged) plus user tags.
+    static_assert(VM_TAG_COUNT < 256, "VM_TAG_COUNT must fit a uint8_t tag id");
+
+    TagStats tag_table[TAG_SLOTS]; ///< Counters per tag.
+    uint8_t current_tag = 0;       ///< Tag charged for new allocations.
+
+    // -------------------- Page-event trace --------------------
+    static constexpr size_t TRACE_EVENTS = VM_TRACE_EVENTS;                     ///< Ring capacity.
+    static constexpr size_t TRACE_SLOTS  = VM_TRACE_EVENTS ? VM_TRACE_EVENTS : 1; ///< Array size (never zero).
+
+    TraceEvent trace_ring[TRACE_SLOTS]; ///< Trace ring buffer.
+    uint32_t trace_total = 0;           ///< Events recorded since the last trace_clear().
+
+    // -------------------- Access-log capture --------------------
+    static constexpr size_t   ACCESS_LOG_SLOTS   = VM_ACCESS_LOG;
+    static constexpr uint32_t ACCESS_LOG_MAGIC   = 0x54414D56u; // 'VMAT'
+    static constexpr uint32_t ACCESS_LOG_VERSION = 1;
+    static constexpr uint32_t ACCESS_LOG_READ    = 0u << 30;
+    static constexpr uint32_t ACCESS_LOG_WRITE   = 1u << 30;
+    static constexpr uint32_t ACCESS_LOG_FREE    = 2u << 30;
+
+#if VM_HAVE_FS
+    fs::File access_log_file;                                        ///< Open access log.
+#endif
+    uint32_t access_log_buf[ACCESS_LOG_SLOTS ? ACCESS_LOG_SLOTS : 1]; ///< Records not yet written.
+    size_t   access_log_fill = 0;                                    ///< Records in access_log_buf.
+    bool     access_log_on = false;                                  ///< Capture active.
+
+    /**
+     * @brief Append one record to the access log (no-op unless capture is active).
+     * @param kind ACCESS_LOG_READ, ACCESS_LOG_WRITE or ACCESS_LOG_FREE.
+     * @param page Page index.
+     * @param offset Byte offset from the start of the page.
+     */
+    void access_log(uint32_t kind, int page, size_t offset) {
+        if (!ACCESS_LOG_SLOTS || !access_log_on) return;
+        access_log_buf[access_log_fill++] = kind | (((uint32_t)page * (uint32_t)page_size + (uint32_t)offset) & 0x3FFFFFFFu);
+        if (access_log_fill == ACCESS_LOG_SLOTS) access_log_flush();
+    }
+
+    /**
+     * @brief Write buffered access-log records to the file.
+     */
+    void access_log_flush() {
+        if (!ACCESS_LOG_SLOTS || !access_log_fill) return;
+#if VM_HAVE_FS
+        access_log_file.write(reinterpret_cast<const uint8_t*>(access_log_buf), access_log_fill * sizeof(uint32_t));
+#endif
+        access_log_fill = 0;
+    }
+
+    // -------------------- Miss-ratio-curve estimation --------------------
+    static constexpr bool   MRC_ENABLED = VM_MRC != 0;
+    static constexpr size_t MRC_SLOTS   = VM_MRC ? VM_PAGE_COUNT : 1; ///< LRU stack capacity (sampled pages).
+
+    int16_t  mrc_stack[MRC_SLOTS];         ///< Sampled pages, most recently accessed first.
+    size_t   mrc_depth = 0;                ///< Entries in mrc_stack.
+    uint32_t mrc_hist[MRC_SLOTS + 1] = {}; ///< Reuse-distance histogram (last bucket: >= page count).
+    uint32_t mrc_sampled = 0;              ///< Sampled accesses.
+
+    /**
+     * @brief Whether a page belongs to the SHARDS sample set (fixed per page id).
+     * @param head Page index.
+     */
+    static bool mrc_sampled_page(int head) {
+        uint32_t h = (uint32_t)head * 2654435761u; // Knuth multiplicative hash
+        h ^= h >> 16;
+        return (h & ((1u << VM_MRC_SAMPLE_SHIFT) - 1)) == 0;
+    }
+
+    /**
+     * @brief Record one access for the miss-ratio curve (no-op unless VM_MRC).
+     * @param head Unit head page index.
+     */
+    void mrc_access(int head) {
+        if (!MRC_ENABLED || !mrc_sampled_page(head)) return;
+        ++mrc_sampled;
+        size_t i = 0;
+        size_t above = 0; // pages of the sampled units touched since the last access
+        while (i < mrc_depth && mrc_stack[i] != head) above += unit_len(mrc_stack[i++]);
+        if (i < mrc_depth) {
+            const size_t dist = (above << VM_MRC_SAMPLE_SHIFT) + unit_len(head) - 1;
+            mrc_hist[dist < page_count ? dist : page_count]++;
+        } else if (mrc_depth < MRC_SLOTS) {
+            i = mrc_depth++;
+        } else {
+            i = mrc_depth - 1; // cannot happen (stack holds distinct pages); keep it bounded anyway
+        }
+        for (; i > 0; --i) mrc_stack[i] = mrc_stack[i - 1];
+        mrc_stack[0] = (int16_t)head;
+    }
+
+    /**
+     * @brief Drop a freed page from the LRU stack so its next use counts as a first touch.
+     * @param head Unit head page index.
+     */
+    void mrc_forget(int head) {
+        if (!MRC_ENABLED) return;
+        size_t i = 0;
+        while (i < mrc_depth && mrc_stack[i] != head) ++i;
+        if (i == mrc_depth) return;
+        for (--mrc_depth; i < mrc_depth; ++i) mrc_stack[i] = mrc_stack[i + 1];
+    }
+
+    // -------------------- Latency histograms --------------------
+    static constexpr bool   LATENCY_ENABLED = VM_LATENCY_STATS != 0;
+    static constexpr size_t LATENCY_OPS     = TRACE_HEAP_ALLOC + 1;                ///< swap_in, swap_out, evict, heap_alloc.
+    static constexpr size_t LATENCY_SLOTS   = VM_LATENCY_STATS ? LATENCY_OPS : 1; ///< Array size (never zero).
+
+    VMLatencyHistogram latency_hist[LATENCY_SLOTS]; ///< Per-operation latency histograms.
+
+    /**
+     * @brief Start timestamp of a timed operation (0 without tracing or latency stats, so the clock is not read).
+     */
+    static uint32_t op_start() { return (TRACE_EVENTS || LATENCY_ENABLED) ? vm_micros() : 0; }
+
+    /**
+     * @brief Finish a timed operation: record its latency and append it to the trace ring.
+     * @param type TraceType.
+     * @param page Page index.
+     * @param arg Type-specific argument.
+     * @param t0 Start timestamp from op_start().
+     * @param reason TraceReason.
+     * @param timed False to trace the operation without recording a latency sample.
+     *
+     * @details No-op when both VM_TRACE_EVENTS and VM_LATENCY_STATS are 0.
+     */
+    void op_done(uint8_t type, int page, uint32_t arg, uint32_t t0, uint8_t reason = TRACE_REASON_NONE,
+                 bool timed = true) {
+        if (!TRACE_EVENTS && !LATENCY_ENABLED) return;
+        const uint32_t dur = vm_micros() - t0;
+        if (LATENCY_ENABLED && timed && type < LATENCY_OPS) latency_hist[type].record(dur);
+        if (!TRACE_EVENTS) return;
+        TraceEvent& e = trace_ring[trace_total % TRACE_SLOTS];
+        e.ts_us = t0;
+        e.dur_us = dur;
+        e.arg = arg;
+        e.page = (int16_t)page;
+        e.type = type;
+        e.reason = reason;
+        ++trace_total;
+    }
+
+    /**
+     * @brief Counters of a tag, or nullptr when accounting is disabled.
+     * @param tag Tag id.
+     */
+    TagStats* tag_slot(uint8_t tag) {
+        return (TAG_COUNT && tag < TAG_SLOTS) ? &tag_table[tag] : nullptr;
+    }
+
+    /**
+     * @brief Tag a freshly allocated small block and charge its size.
+     * @param page Physical heap page (resident).
+     * @param off Physical payload offset.
+     * @param tag Tag to charge.
+     */
+    void charge_block(int page, size_t off, uint8_t tag) {
+        TagStats* ts = tag_slot(tag);
+        if (!ts) return;
+        BlockHeader* bh = reinterpret_cast<BlockHeader*>(pages[page].ram_addr + off - BH_SIZE);
+        bh->tag = tag;
+        ts->heap_bytes += bh->size;
+        ts->heap_blocks++;
+        pages[page].io_tag = tag;
+    }
+
+    /**
+     * @brief Check whether a page index is a handle pseudo index.
+     * @param page Page index as stored by a container.
+     * @return True if page refers to handles[page - page_count].
+     */
+    bool is_handle(int page) const {
+        return HANDLE_COUNT && page >= (int)page_count && page < (int)(page_count + HANDLE_COUNT);
+    }
+
+    /**
+     * @brief Translate a (page, payload offset) pair as stored by a container to its physical location.
+     * @param page In: stored page index; out: physical page index.
+     * @param off In: stored offset; out: physical offset.
+     */
+    void resolve_block(int& page, size_t& off) const {
+        if (is_handle(page)) {
+            const HeapHandle& h = handles[page - page_count];
+            off += h.offset;
+            page = h.page;
+        }
+    }
+
+    /**
+     * @brief Physical page of a stored page index (identity unless it is a handle).
+     * @param page Stored page index.
+     * @return Physical page index.
+     */
+    int block_page(int page) const {
+        return is_handle(page) ? handles[page - page_count].page : page;
+    }
 
     /**
      * @brief Align up to HEAP_ALIGN.
@@ -310,28 +2397,150 @@ private:
         }
         HeapHeader* hh = reinterpret_cast<HeapHeader*>(pg.ram_addr);
         if (pg.zero_filled || !pg.is_heap || hh->magic != HEAP_MAGIC || hh->version != HEAP_VERSION) {
-            // Initialize a new heap header and a single free block.
-            memset(pg.ram_addr, 0, page_size);
-            hh->magic = HEAP_MAGIC;
-            hh->version = HEAP_VERSION;
-            hh->reserved = 0;
-            size_t first_block_off = HH_SIZE;
-            size_t usable = (page_size > first_block_off + BH_SIZE) ? (page_size - first_block_off - BH_SIZE) : 0;
-            if (usable == 0) return false;
-            BlockHeader* bh = reinterpret_cast<BlockHeader*>(pg.ram_addr + first_block_off);
-            bh->size = (uint32_t)align_up(usable);
-            bh->next_free = 0;
-            bh->flags = 1; // free
-            bh->reserved = 0;
-            hh->first_free = (uint32_t)first_block_off;
-            hh->total_free = (uint32_t)bh->size;
-            pg.is_heap = true;
-            pg.zero_filled = false;
-            pg.dirty = true;
+            if (!init_heap_header(idx)) return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Write a fresh heap header and a single free block covering the page.
+     * @param idx Resident page index.
+     * @return True on success.
+     */
+    bool init_heap_header(int idx) {
+        VMPage& pg = pages[idx];
+        HeapHeader* hh = reinterpret_cast<HeapHeader*>(pg.ram_addr);
+        memset(pg.ram_addr, 0, page_size);
+        hh->magic = HEAP_MAGIC;
+        hh->version = HEAP_VERSION;
+        hh->live = 0;
+        size_t first_block_off = HH_SIZE;
+        size_t usable = (page_size > first_block_off + BH_SIZE) ? (page_size - first_block_off - BH_SIZE) : 0;
+        if (usable == 0) return false;
+        BlockHeader* bh = reinterpret_cast<BlockHeader*>(pg.ram_addr + first_block_off);
+        bh->size = (uint32_t)align_up(usable);
+        bh->next_free = 0;
+        bh->flags = 1; // free
+        bh->reserved = 0;
+        hh->first_free = (uint32_t)first_block_off;
+        hh->total_free = (uint32_t)bh->size;
+        pg.is_heap = true;
+        pg.heap_live = 0;
+        pg.heap_total_free = hh->total_free;
+        pg.heap_largest_free = bh->size;
+        pg.zero_filled = false;
+        pg.dirty = true;
+        return true;
+    }
+
+    /**
+     * @brief Move one handle-backed block into a heap page fuller than the source.
+     * @param src Source heap page.
+     * @param payload_off Payload offset of the block in src.
+     * @param src_free Source page's free bytes (targets must have less).
+     * @return True if the block was moved and its handle updated.
+     *
+     * @details The source page is pinned while targets are loaded, so its frame (and bh, from)
+     * stays valid; with a single free frame no target can be loaded and the move is skipped.
+     */
+    bool move_block(int src, size_t payload_off, uint32_t src_free) {
+        const int pinned = pin_unit(src);
+        if (pinned < 0) return false;
+        BlockHeader* bh = reinterpret_cast<BlockHeader*>(pages[src].ram_addr + payload_off - BH_SIZE);
+        const size_t size = bh->size;
+        const uint16_t hid = bh->reserved;
+        const uint8_t tag = (uint8_t)bh->tag; // bh is not used once other pages are loaded
+        int dst = -1;
+        size_t dst_off = 0;
+        size_t dst_size = 0;
+        for (size_t t = 0; t < page_count && dst < 0; ++t) {
+            if ((int)t == src || !pages[t].allocated || !pages[t].is_heap) continue;
+            if (pages[t].heap_total_free >= src_free || pages[t].heap_largest_free < size) continue;
+            if (!ensure_heap_header((int)t)) continue;
+            if (heap_alloc_from((int)t, size, &dst_off, &dst_size)) dst = (int)t;
+        }
+        if (dst < 0) {
+            unpin_unit(pinned);
+            return false;
         }
+        void* from = get_read_ptr(src, payload_off);
+        void* to = get_write_ptr(dst, dst_off);
+        if (!from || !to) {
+            unpin_unit(pinned); // heap_free() may need src's frame to load dst
+            heap_free(dst, dst_off);
+            return false;
+        }
+        memcpy(to, from, size);
+        reinterpret_cast<BlockHeader*>(pages[dst].ram_addr + dst_off - BH_SIZE)->reserved = hid;
+        if (TAG_COUNT) charge_block(dst, dst_off, tag);
+        handles[hid - 1].page = dst;
+        handles[hid - 1].offset = (uint32_t)dst_off;
+        unpin_unit(pinned);
+        heap_free(src, payload_off);
         return true;
     }
 
+    /**
+     * @brief Slide the handle-backed blocks of a heap page toward its start, merging free space.
+     * @param idx Heap page index.
+     * @return Number of blocks moved.
+     *
+     * @details Blocks without a handle stay in place; free space between them becomes one free
+     * block per gap. The rebuilt free list is in address order.
+     */
+    size_t slide_heap_page(int idx) {
+        if (!ensure_heap_header(idx)) return 0;
+        uint8_t* base = pages[idx].ram_addr;
+        HeapHeader* hh = reinterpret_cast<HeapHeader*>(base);
+        uint32_t free_head = 0;
+        uint32_t free_tail = 0;
+        uint32_t total = 0;
+        // Turn [at, end) into one free block appended to the new free list.
+        auto emit_free = [&](size_t at, size_t end) {
+            if (end <= at) return;
+            BlockHeader* f = reinterpret_cast<BlockHeader*>(base + at);
+            f->size = (uint32_t)(end - at - BH_SIZE);
+            f->next_free = 0;
+            f->flags = 1;
+            f->reserved = 0;
+            if (free_tail) reinterpret_cast<BlockHeader*>(base + free_tail)->next_free = (uint32_t)at;
+            else free_head = (uint32_t)at;
+            free_tail = (uint32_t)at;
+            total += f->size;
+        };
+
+        size_t moved = 0;
+        size_t cursor = HH_SIZE;
+        size_t off = HH_SIZE;
+        while (off + BH_SIZE <= page_size) {
+            BlockHeader* bh = reinterpret_cast<BlockHeader*>(base + off);
+            const size_t span = BH_SIZE + bh->size;
+            const uint16_t hid = bh->reserved;
+            if ((bh->flags & 1) == 0) {
+                if (hid == 0) {
+                    emit_free(cursor, off); // pinned block: close the gap in front of it
+                    cursor = off + span;
+                } else {
+                    if (off != cursor) {
+                        memmove(base + cursor, base + off, span);
+                        handles[hid - 1].offset = (uint32_t)(cursor + BH_SIZE);
+                        ++moved;
+                    }
+                    cursor += span;
+                }
+            }
+            off += span;
+        }
+        emit_free(cursor, page_size);
+        hh->first_free = free_head;
+        hh->total_free = total;
+        pages[idx].heap_total_free = total;
+        refresh_largest_free(idx);
+        pages[idx].dirty = true;
+        if (moved) bump_generation(idx);
+        return moved;
+    }
+
     /**
      * @brief Allocate a new heap page (dedicated to small-block allocator).
      * @param out_idx Output page index.
@@ -359,151 +2568,106 @@ private:
      * @param out_page Output page index.
      * @param out_off Output payload offset in page.
      * @param out_alloc_size Output actual payload size reserved (>= requested).
+     * @param hint Preferred page (stored page index of a related block, or -1 for none).
      * @return True on success.
      */
-    bool heap_alloc(size_t size, size_t /*align*/, int* out_page, size_t* out_off, size_t* out_alloc_size) {
+    bool heap_alloc(size_t size, size_t /*align*/, int* out_page, size_t* out_off, size_t* out_alloc_size,
+                    int hint = -1) {
         const size_t need = align_up(size);
-        // 1) Search existing heap pages
-        for (size_t i = 0; i < page_count; ++i) {
-            VMPage& pg = pages[i];
-            if (!pg.allocated || !pg.is_heap) continue;
-            if (!ensure_heap_header((int)i)) continue;
-            HeapHeader* hh = reinterpret_cast<HeapHeader*>(pg.ram_addr);
-            // Quick filter
-            if (hh->total_free < need) continue;
-
-            uint32_t prev_off = 0;
-            uint32_t cur_off = hh->first_free;
-            while (cur_off) {
-                BlockHeader* cur = reinterpret_cast<BlockHeader*>(pg.ram_addr + cur_off);
-                if ((cur->flags & 1) && cur->size >= need) {
-                    // Found a block; split if large enough to hold another header + 1 byte
-                    const size_t remaining = (size_t)cur->size - need;
-                    if (remaining >= BH_SIZE + HEAP_ALIGN) {
-                        // Split: allocated part stays at cur_off, remainder becomes new free block after it
-                        const uint32_t alloc_off = cur_off;
-                        const uint32_t new_free_off = alloc_off + (uint32_t)BH_SIZE + (uint32_t)need;
-                        BlockHeader* new_free = reinterpret_cast<BlockHeader*>(pg.ram_addr + new_free_off);
-                        new_free->size = (uint32_t)align_up(remaining - BH_SIZE);
-                        new_free->flags = 1; // free
-                        new_free->reserved = 0;
-                        // insert new_free into free list in place of cur
-                        new_free->next_free = cur->next_free;
-
-                        // Mark current as used
-                        cur->size = (uint32_t)need;
-                        cur->flags = 0; // used
-                        cur->next_free = 0;
-
-                        // Update free list head/prev
-                        if (prev_off == 0) {
-                            hh->first_free = new_free_off;
-                        } else {
-                            BlockHeader* prev = reinterpret_cast<BlockHeader*>(pg.ram_addr + prev_off);
-                            prev->next_free = new_free_off;
-                        }
-                        // Update accounting
-                        hh->total_free -= (uint32_t)(need + BH_SIZE);
-                        pg.dirty = true;
-
-                        if (out_page) *out_page = (int)i;
-                        if (out_off) *out_off = alloc_off + BH_SIZE;
-                        if (out_alloc_size) *out_alloc_size = need;
-                        return true;
-                    } else {
-                        // Take the whole block without split
-                        // Remove from free list
-                        if (prev_off == 0) {
-                            hh->first_free = cur->next_free;
-                        } else {
-                            BlockHeader* prev = reinterpret_cast<BlockHeader*>(pg.ram_addr + prev_off);
-                            prev->next_free = cur->next_free;
-                        }
-                        // Mark used
-                        cur->flags = 0;
-                        uint32_t alloc_size = cur->size;
-                        cur->next_free = 0;
-
-                        // Accounting
-                        if (hh->total_free >= alloc_size)
-                            hh->total_free -= alloc_size;
-                        else
-                            hh->total_free = 0;
-                        pg.dirty = true;
-
-                        if (out_page) *out_page = (int)i;
-                        if (out_off) *out_off = cur_off + BH_SIZE;
-                        if (out_alloc_size) *out_alloc_size = alloc_size;
-                        return true;
-                    }
-                }
-                prev_off = cur_off;
-                cur_off = cur->next_free;
-            }
+        if (need > heap_max_payload()) return false; // never fits; don't grab a fresh heap page
+        const uint32_t t0 = op_start();
+        // 1) Pick an existing heap page from the RAM-side summary (no swap-in just to look):
+        //    the hinted page if it has room, else a resident page, else fault in only the chosen one.
+        int pick = -1;
+        hint = block_page(hint);
+        const bool hinted = valid_index(hint) && pages[hint].allocated && pages[hint].is_heap &&
+                            pages[hint].heap_largest_free >= need;
+        if (hinted) pick = hint;
+        for (size_t i = 0; i < page_count && !hinted; ++i) {
+            const VMPage& pg = pages[i];
+            if (!pg.allocated || !pg.is_heap || pg.heap_largest_free < need) continue;
+            if (pg.in_ram && pg.ram_addr) { pick = (int)i; break; }
+            if (pick < 0) pick = (int)i;
+        }
+        if (pick >= 0 && ensure_heap_header(pick) && heap_alloc_from(pick, need, out_off, out_alloc_size)) {
+            if (out_page) *out_page = pick;
+            op_done(TRACE_HEAP_ALLOC, pick, (uint32_t)need, t0);
+            return true;
         }
 
         // 2) No fit found -> allocate a new heap page and retry there
         int new_idx = -1;
         if (!alloc_heap_page(&new_idx)) return false;
-        VMPage& pg = pages[new_idx];
         if (!ensure_heap_header(new_idx)) return false;
+        if (!heap_alloc_from(new_idx, need, out_off, out_alloc_size)) return false;
+        if (out_page) *out_page = new_idx;
+        op_done(TRACE_HEAP_ALLOC, new_idx, (uint32_t)need, t0);
+        return true;
+    }
+
+    /**
+     * @brief Allocate a block from one heap page (first fit on its free list).
+     * @param idx Heap page index (header must be initialized and resident).
+     * @param need Payload size, already aligned.
+     * @param out_off Output payload offset in page.
+     * @param out_alloc_size Output actual payload size reserved (>= need).
+     * @return True on success, false if no free block of the page fits.
+     */
+    bool heap_alloc_from(int idx, size_t need, size_t* out_off, size_t* out_alloc_size) {
+        VMPage& pg = pages[idx];
         HeapHeader* hh = reinterpret_cast<HeapHeader*>(pg.ram_addr);
-        // Immediately allocate from the single free block
         uint32_t prev_off = 0;
         uint32_t cur_off = hh->first_free;
         while (cur_off) {
             BlockHeader* cur = reinterpret_cast<BlockHeader*>(pg.ram_addr + cur_off);
             if ((cur->flags & 1) && cur->size >= need) {
-                // Same split/take logic as above
+                // Found a block; split if large enough to hold another header + 1 byte
                 const size_t remaining = (size_t)cur->size - need;
+                const size_t found_size = cur->size;
+                uint32_t next_free = cur->next_free;
+                size_t alloc_size = cur->size;
                 if (remaining >= BH_SIZE + HEAP_ALIGN) {
-                    const uint32_t alloc_off = cur_off;
-                    const uint32_t new_free_off = alloc_off + (uint32_t)BH_SIZE + (uint32_t)need;
+                    // Split: allocated part stays at cur_off, remainder becomes new free block after it
+                    const uint32_t new_free_off = cur_off + (uint32_t)BH_SIZE + (uint32_t)need;
                     BlockHeader* new_free = reinterpret_cast<BlockHeader*>(pg.ram_addr + new_free_off);
                     new_free->size = (uint32_t)align_up(remaining - BH_SIZE);
-                    new_free->flags = 1;
+                    new_free->flags = 1; // free
                     new_free->reserved = 0;
+                    // insert new_free into free list in place of cur
                     new_free->next_free = cur->next_free;
-
+                    next_free = new_free_off;
                     cur->size = (uint32_t)need;
-                    cur->flags = 0;
-                    cur->next_free = 0;
-
-                    if (prev_off == 0) {
-                        hh->first_free = new_free_off;
-                    } else {
-                        BlockHeader* prev = reinterpret_cast<BlockHeader*>(pg.ram_addr + prev_off);
-                        prev->next_free = new_free_off;
-                    }
+                    alloc_size = need;
                     hh->total_free -= (uint32_t)(need + BH_SIZE);
-                    pg.dirty = true;
-
-                    if (out_page) *out_page = new_idx;
-                    if (out_off) *out_off = alloc_off + BH_SIZE;
-                    if (out_alloc_size) *out_alloc_size = need;
-                    return true;
                 } else {
-                    if (prev_off == 0) {
-                        hh->first_free = cur->next_free;
-                    } else {
-                        BlockHeader* prev = reinterpret_cast<BlockHeader*>(pg.ram_addr + prev_off);
-                        prev->next_free = cur->next_free;
-                    }
-                    cur->flags = 0;
-                    uint32_t alloc_size = cur->size;
-                    cur->next_free = 0;
-
+                    // Take the whole block without split
                     if (hh->total_free >= alloc_size)
-                        hh->total_free -= alloc_size;
+                        hh->total_free -= (uint32_t)alloc_size;
                     else
                         hh->total_free = 0;
-                    pg.dirty = true;
-
-                    if (out_page) *out_page = new_idx;
-                    if (out_off) *out_off = cur_off + BH_SIZE;
-                    if (out_alloc_size) *out_alloc_size = alloc_size;
-                    return true;
                 }
+                // Update free list head/prev
+                if (prev_off == 0) {
+                    hh->first_free = next_free;
+                } else {
+                    BlockHeader* prev = reinterpret_cast<BlockHeader*>(pg.ram_addr + prev_off);
+                    prev->next_free = next_free;
+                }
+                // Mark current as used
+                cur->flags = 0;
+                cur->next_free = 0;
+                cur->reserved = 0;
+                cur->tag = 0;
+                hh->live++;
+                pg.heap_live = hh->live;
+                pg.heap_total_free = hh->total_free;
+                // Only taking (part of) the largest block can lower the largest free size.
+                if (found_size >= pg.heap_largest_free) refresh_largest_free(idx);
+                pg.dirty = true;
+
+                if (out_off) *out_off = cur_off + BH_SIZE;
+                if (out_alloc_size) *out_alloc_size = alloc_size;
+                return true;
             }
             prev_off = cur_off;
             cur_off = cur->next_free;
@@ -512,7 +2676,93 @@ private:
     }
 
     /**
-     * @brief Free a previously allocated small block by payload offset.
+     * @brief Carve up to 'count' equal blocks from one heap page in a single free-list pass.
+     * @param idx Heap page index (header must be initialized and resident).
+     * @param need Payload size, already aligned.
+     * @param count Maximum number of blocks to allocate.
+     * @param out_offs Output payload offsets (at least 'count' entries).
+     * @return Number of blocks allocated (0 if no free block of the page fits).
+     *
+     * @details Each fitting free block is split once into as many back-to-back blocks as it
+     * holds; the tail stays on the free list, or is absorbed into the last block when too small
+     * to carry a header. The page header and summary are updated once per call.
+     */
+    size_t heap_alloc_run(int idx, size_t need, size_t count, size_t* out_offs) {
+        VMPage& pg = pages[idx];
+        HeapHeader* hh = reinterpret_cast<HeapHeader*>(pg.ram_addr);
+        const size_t stride = BH_SIZE + need;
+        size_t done = 0;
+        bool took_largest = false;
+        uint32_t prev_off = 0;
+        uint32_t cur_off = hh->first_free;
+        while (cur_off && done < count) {
+            BlockHeader* cur = reinterpret_cast<BlockHeader*>(pg.ram_addr + cur_off);
+            const uint32_t next_off = cur->next_free;
+            if (!(cur->flags & 1) || cur->size < need) {
+                prev_off = cur_off;
+                cur_off = next_off;
+                continue;
+            }
+            if (cur->size >= pg.heap_largest_free) took_largest = true;
+            const size_t footprint = BH_SIZE + cur->size;
+            const size_t k = std::min(count - done, footprint / stride);
+            const size_t rest = footprint - k * stride;
+            uint32_t replace = next_off; // what takes cur's place on the free list
+            if (rest >= BH_SIZE + HEAP_ALIGN) {
+                const uint32_t rest_off = cur_off + (uint32_t)(k * stride);
+                BlockHeader* r = reinterpret_cast<BlockHeader*>(pg.ram_addr + rest_off);
+                r->size = (uint32_t)(rest - BH_SIZE);
+                r->next_free = next_off;
+                r->flags = 1; // free
+                r->reserved = 0;
+                replace = rest_off;
+                hh->total_free -= (uint32_t)(k * stride);
+            } else {
+                hh->total_free = hh->total_free >= cur->size ? hh->total_free - cur->size : 0;
+            }
+            for (size_t j = 0; j < k; ++j) {
+                const uint32_t off = cur_off + (uint32_t)(j * stride);
+                BlockHeader* b = reinterpret_cast<BlockHeader*>(pg.ram_addr + off);
+                b->size = (uint32_t)(j + 1 == k && replace == next_off ? need + rest : need);
+                b->next_free = 0;
+                b->flags = 0;
+                b->reserved = 0;
+                b->tag = 0;
+                out_offs[done++] = off + BH_SIZE;
+            }
+            if (prev_off == 0) hh->first_free = replace;
+            else reinterpret_cast<BlockHeader*>(pg.ram_addr + prev_off)->next_free = replace;
+            hh->live = (uint16_t)(hh->live + k);
+            if (replace != next_off) prev_off = replace;
+            cur_off = next_off;
+        }
+        if (done) {
+            pg.heap_live = hh->live;
+            pg.heap_total_free = hh->total_free;
+            if (took_largest) refresh_largest_free(idx);
+            pg.dirty = true;
+        }
+        return done;
+    }
+
+    /**
+     * @brief Recompute VMPage::heap_largest_free by walking a resident heap page's free list.
+     * @param idx Heap page index (header must be resident).
+     */
+    void refresh_largest_free(int idx) {
+        VMPage& pg = pages[idx];
+        const HeapHeader* hh = reinterpret_cast<HeapHeader*>(pg.ram_addr);
+        uint32_t largest = 0;
+        for (uint32_t off = hh->first_free; off; ) {
+            const BlockHeader* b = reinterpret_cast<BlockHeader*>(pg.ram_addr + off);
+            if (b->size > largest) largest = b->size;
+            off = b->next_free;
+        }
+        pg.heap_largest_free = largest;
+    }
+
+    /**
+     * @brief Free a previously allocated small block by payload offset; releases the page once empty.
      * @param page_idx Page index the block resides in.
      * @param payload_off Offset to payload (not header).
      */
@@ -520,6 +2770,7 @@ private:
         if (!valid_index(page_idx)) return;
         VMPage& pg = pages[page_idx];
         if (!pg.allocated || !pg.is_heap) return;
+        const uint32_t t0 = op_start();
         if (!ensure_heap_header(page_idx)) return;
         if (payload_off < BH_SIZE) return;
         size_t hdr_off = payload_off - BH_SIZE;
@@ -530,27 +2781,93 @@ private:
 
         // Basic sanity
         if ((bh->flags & 1) == 0) {
+            if (TagStats* ts = tag_slot((uint8_t)bh->tag)) {
+                ts->heap_bytes -= bh->size;
+                ts->heap_blocks--;
+            }
             // Mark as free and push to free list head (no coalescing to keep it simple)
             bh->flags = 1;
+            bh->tag = 0;
+            bh->reserved = 0;
             bh->next_free = hh->first_free;
             hh->first_free = (uint32_t)hdr_off;
             hh->total_free += bh->size;
             pg.dirty = true;
+            if (hh->live) hh->live--;
+            pg.heap_live = hh->live;
+            pg.heap_total_free = hh->total_free;
+            if (bh->size > pg.heap_largest_free) pg.heap_largest_free = bh->size;
+            const uint32_t freed = bh->size;
+            if (hh->live == 0) release_empty_heap_page(page_idx);
+            op_done(TRACE_HEAP_FREE, page_idx, freed, t0);
+        }
+    }
+
+    /**
+     * @brief Release a heap page whose last block was just freed.
+     * @param idx Heap page index (live count 0).
+     *
+     * @details The page is discarded (RAM freed, no write-back, swap slot marked zero) unless
+     * fewer than VM_HEAP_RESERVE_PAGES other empty heap pages exist; a reserve page is reset to
+     * a single free block instead, so alloc/free cycles around a page boundary do not churn.
+     */
+    void release_empty_heap_page(int idx) {
+        size_t empty = 0;
+        for (size_t i = 0; i < page_count; ++i) {
+            if ((int)i != idx && pages[i].allocated && pages[i].is_heap && pages[i].heap_live == 0) ++empty;
+        }
+        if (empty < HEAP_RESERVE_PAGES) init_heap_header(idx);
+        else discard_page(idx);
+    }
+
+    /**
+     * @brief Theoretical maximum payload size for a single small block within one page.
+     * @return Max payload bytes.
+     */
+    size_t heap_max_payload() const {
+        // one header and one block header overhead
+        if (page_size <= HH_SIZE + BH_SIZE) return 0;
+        return page_size - HH_SIZE - BH_SIZE;
+    }
+
+    // -------------------- Private helpers (used by friends) --------------------
+
+    /**
+     * @brief Check whether blocking swap I/O may run now.
+     * @return True outside no-fault scopes; inside one, counts a violation and returns false if strict.
+     */
+    bool io_permitted() {
+        if (!no_fault_depth) return true;
+        ++no_fault_count;
+        return !no_fault_strict;
+    }
+
+    /**
+     * @brief Fault in a unit and pin it in RAM.
+     * @param idx Stored page index (handle pseudo indices resolve to their heap page).
+     * @return Head page that was pinned, or -1 if the index is invalid or the unit cannot be loaded.
+     */
+    int pin_unit(int idx) {
+        if (idx < 0) return -1;
+        const int page = block_page(idx);
+        if (!valid_index(page) || !pages[page].allocated) return -1;
+        const int head = unit_head(page);
+        if (!pages[head].in_ram || !pages[head].ram_addr) {
+            if (!swap_in(head)) return -1;
         }
+        if (pages[head].pin_count == 0xFF) return -1;
+        pages[head].pin_count++;
+        return head;
     }
 
     /**
-     * @brief Theoretical maximum payload size for a single small block within one page.
-     * @return Max payload bytes.
+     * @brief Drop one pin of a unit (no-op if the unit was freed meanwhile).
+     * @param head Head page returned by pin_unit().
      */
-    size_t heap_max_payload() const {
-        // one header and one block header overhead
-        if (page_size <= HH_SIZE + BH_SIZE) return 0;
-        return page_size - HH_SIZE - BH_SIZE;
+    void unpin_unit(int head) {
+        if (valid_index(head) && pages[head].pin_count) pages[head].pin_count--;
     }
 
-    // -------------------- Private helpers (used by friends) --------------------
-
     /**
      * @brief Evict one RAM-resident page using an LRU policy.
      * @return True if a page was evicted (RAM freed), false otherwise.
@@ -559,42 +2876,82 @@ private:
      * Chooses among pages that are allocated, currently resident in RAM (in_ram && ram_addr),
      * and permitted to free RAM (can_free_ram). The victim is the page with the smallest
      * last_access value (least recently used). Dirty pages are flushed via swap_out().
-     * Returns false if no eligible page exists for eviction.
+     * Pinned units are skipped; inside a VMNoFaultScope the LRU clean unit is preferred so
+     * no write-back is needed. Returns false if no eligible page exists for eviction.
      */
-    bool evict_one_page() {
-        int victim = -1;
-        uint64_t best = std::numeric_limits<uint64_t>::max();
+    bool evict_one_page(uint8_t reason = TRACE_REASON_RAM_FULL) {
+        const uint32_t t0 = op_start();
+        int victim = -1, clean = -1;
+        uint64_t best = std::numeric_limits<uint64_t>::max(), best_clean = best;
 
         for (int i = 0; i < (int)page_count; ++i) {
             VMPage& pg = pages[i];
             if (!pg.allocated) continue;
             if (!pg.in_ram || !pg.ram_addr) continue;
-            if (!pg.can_free_ram) continue;
+            if (!pg.can_free_ram || pg.pin_count) continue;
+            if (unit_head(i) != i) continue; // extent members are evicted through their head
             // Pick the least recently accessed page
             if (pg.last_access < best) {
                 best = pg.last_access;
                 victim = i;
             }
+            if (no_fault_depth && pg.last_access < best_clean) {
+                bool unit_dirty = false;
+                for (size_t k = 0; k < unit_len(i); ++k) unit_dirty = unit_dirty || pages[i + k].dirty;
+                if (!unit_dirty) {
+                    best_clean = pg.last_access;
+                    clean = i;
+                }
+            }
         }
+        if (clean >= 0) victim = clean;
         if (victim < 0) return false;
+        bool dirty = false;
+        for (size_t k = 0; k < unit_len(victim); ++k) dirty = dirty || pages[victim + k].dirty;
+        if (dirty && !io_permitted()) return false;
         // swap_out() flushes dirty pages and frees RAM if can_free_ram is true. Returns true on success.
-        return swap_out(victim, false);
+        const bool ok = swap_out(victim, false);
+        op_done(TRACE_EVICT, victim, dirty ? 1 : 0, t0, reason);
+        return ok;
     }
 
     /**
-     * @brief Allocate a page-sized RAM buffer; if malloc fails, evict pages until it succeeds.
+     * @brief Allocate a RAM buffer (one page by default); if malloc fails, evict pages until it succeeds.
+     * @param bytes Buffer size in bytes (0 = one page).
      * @return Pointer to allocated buffer, or nullptr if eviction did not free enough RAM.
      *
      * @details
-     * Repeatedly tries malloc(page_size). On failure, evicts one LRU page and retries.
+     * First evicts LRU pages until the buffer fits under the frame limit (if set).
+     * Then repeatedly tries malloc(bytes). On failure, evicts one LRU page and retries.
      * Attempts are bounded by page_count to avoid unbounded loops. If evict_one_page()
      * returns false (no eligible page to evict), the loop terminates early.
-     */
-    uint8_t* alloc_ram_buffer_with_eviction() {
+     * Whenever an eviction was needed and high watermarks are set, further pages are
+     * evicted in the same batch until they hold again (best effort).
+     */
+    uint8_t* alloc_ram_buffer_with_eviction(size_t bytes = 0) {
+        if (bytes == 0) bytes = page_size;
+        const size_t need = (bytes + page_size - 1) / page_size;
+        bool evicted = false;
+        if (frame_limit) {
+            if (need > frame_limit) return nullptr;
+            while (resident_frames() + need > frame_limit) {
+                if (!evict_one_page()) return nullptr;
+                evicted = true;
+            }
+        }
         for (size_t attempt = 0; attempt < page_count; ++attempt) {
-            uint8_t* p = static_cast<uint8_t*>(malloc(page_size));
-            if (p) return p;
+            uint8_t* p = static_cast<uint8_t*>(malloc(bytes));
+            if (p) {
+                if (evicted && no_fault_depth == 0) {
+                    // Batch: restore the high watermarks now rather than evicting on every later load.
+                    // Not inside a VMNoFaultScope, where extra dirty victims would be violations.
+                    for (size_t k = 0; k < page_count && below_high(need); ++k)
+                        if (!evict_one_page(TRACE_REASON_RECLAIM)) break;
+                }
+                return p;
+            }
             if (!evict_one_page()) break;
+            evicted = true;
         }
         return nullptr;
     }
@@ -606,6 +2963,7 @@ private:
      * @return Pointer to page RAM buffer or nullptr on failure.
      */
     uint8_t* alloc_page_ex(const AllocOptions& opts, int* out_idx = nullptr) {
+        if (SWAP_LOG && opts.reuse_swap_data) return alloc_page_ex(log_alloc_options(opts), out_idx);
         for (size_t i = 0; i < page_count; i++) {
             VMPage& pg = pages[i];
             if (!pg.allocated) {
@@ -617,11 +2975,15 @@ private:
                 pg.can_free_ram = opts.can_free_ram;
                 pg.last_access  = ++access_tick;
                 pg.is_heap      = false;
+                pg.extent_head  = -1;
+                pg.extent_len   = 0;
+                pg.owner_tag    = current_tag;
+                pg.io_tag       = current_tag;
+                if (TagStats* ts = tag_slot(current_tag)) ts->pages++;
 
                 if (opts.reuse_swap_data) {
-                    // Read existing content from swap through the read handle.
-                    swap_read.seek(pg.swap_offset);
-                    swap_read.read(pg.ram_addr, page_size);
+                    // Read existing content from swap.
+                    backend->read(pg.swap_offset, pg.ram_addr, page_size);
                     pg.dirty = false;
                     pg.zero_filled = false;
                 } else {
@@ -651,6 +3013,7 @@ private:
      */
     uint8_t* alloc_page_at(int idx, const AllocOptions& opts) {
         if (!valid_index(idx)) return nullptr;
+        if (SWAP_LOG && opts.reuse_swap_data) return alloc_page_at(idx, log_alloc_options(opts));
         VMPage& pg = pages[idx];
         if (pg.allocated) {
             // Already allocated, ensure in RAM (swap-in) and return pointer.
@@ -667,10 +3030,11 @@ private:
         pg.can_free_ram = opts.can_free_ram;
         pg.last_access  = ++access_tick;
         pg.is_heap      = false;
+        pg.extent_head  = -1;
+        pg.extent_len   = 0;
 
         if (opts.reuse_swap_data) {
-            swap_read.seek(pg.swap_offset);
-            swap_read.read(pg.ram_addr, page_size);
+            backend->read(pg.swap_offset, pg.ram_addr, page_size);
             pg.dirty = false;
             pg.zero_filled = false;
         } else {
@@ -697,6 +3061,142 @@ private:
         return alloc_page_ex(opts, out_idx);
     }
 
+    /**
+     * @brief Allocate an extent: a run of consecutive pages that is resident as one unit.
+     * @param count Number of pages (1 behaves like alloc_page_ex()).
+     * @param opts Allocation options.
+     * @param out_idx Optional output index of the first (head) page.
+     * @return Pointer to the extent's contiguous RAM buffer or nullptr on failure.
+     *
+     * @details
+     * The extent's pages share one RAM buffer of count * page_size bytes and have consecutive
+     * swap slots, so an object spanning page boundaries is contiguous in RAM and the whole
+     * extent is swapped in or out with one sequential I/O. Its pages are loaded, evicted and
+     * freed together (pinned to each other), addressed through any member page index.
+     */
+    uint8_t* alloc_extent_ex(size_t count, const AllocOptions& opts, int* out_idx = nullptr) {
+        if (count <= 1) return alloc_page_ex(opts, out_idx);
+        if (count > page_count) return nullptr;
+        if (SWAP_LOG && count > LOG_SEG_PAGES) return nullptr; // a unit must fit one log segment
+        if (SWAP_LOG && opts.reuse_swap_data) return alloc_extent_ex(count, log_alloc_options(opts), out_idx);
+        for (size_t start = 0; start + count <= page_count; ++start) {
+            size_t run = 0;
+            while (run < count && !pages[start + run].allocated) ++run;
+            if (run < count) { start += run; continue; }
+
+            uint8_t* buf = alloc_ram_buffer_with_eviction(count * page_size);
+            if (!buf) return nullptr;
+            for (size_t k = 0; k < count; ++k) {
+                VMPage& pg = pages[start + k];
+                pg.ram_addr     = buf + k * page_size;
+                pg.allocated    = true;
+                pg.in_ram       = true;
+                pg.can_free_ram = opts.can_free_ram;
+                pg.last_access  = ++access_tick;
+                pg.is_heap      = false;
+                pg.extent_head  = (int)start;
+                pg.extent_len   = (k == 0) ? count : 0;
+                pg.owner_tag    = current_tag;
+                pg.io_tag       = current_tag;
+                if (TagStats* ts = tag_slot(current_tag)) ts->pages++;
+                if (opts.reuse_swap_data) {
+                    pg.dirty = false;
+                    pg.zero_filled = false;
+                } else {
+                    pg.zero_filled = opts.zero_on_alloc;
+                    pg.dirty = true; // initial content must be persisted
+                }
+            }
+            if (opts.reuse_swap_data) {
+                backend->read(pages[start].swap_offset, buf, count * page_size);
+            } else if (opts.zero_on_alloc) {
+                memset(buf, 0, count * page_size);
+            }
+            if (out_idx) *out_idx = (int)start;
+            return buf;
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Head page of the residency unit containing idx (idx itself for plain pages).
+     * @param idx Valid page index.
+     * @return Head page index.
+     */
+    int unit_head(int idx) const {
+        return pages[idx].extent_head >= 0 ? pages[idx].extent_head : idx;
+    }
+
+    /**
+     * @brief Number of pages in the residency unit headed by head (1 for plain pages).
+     * @param head Head page index.
+     * @return Page count.
+     */
+    size_t unit_len(int head) const {
+        return pages[head].extent_len ? pages[head].extent_len : 1;
+    }
+
+    /**
+     * @brief Bytes addressable from the start of page idx to the end of its residency unit.
+     * @param idx Valid page index.
+     * @return page_size for plain pages; remaining extent bytes for extent members.
+     */
+    size_t span_bytes(int idx) const {
+        const int head = unit_head(idx);
+        return (head + unit_len(head) - idx) * page_size;
+    }
+
+    /**
+     * @brief Invalidate cached frame pointers into a residency unit.
+     * @param head Head page index.
+     *
+     * @details Called whenever the unit's RAM buffer is freed or replaced, its pages are
+     *          cleaned (so a cached write pointer must go through the dirty-marking path again),
+     *          or heap blocks are relocated out of it. Values come from a global counter, so a
+     *          pointer cached for one page never validates against another.
+     */
+    void bump_generation(int head) {
+        const size_t n = unit_len(head);
+        for (size_t k = 0; k < n; ++k) pages[head + k].generation = ++generation_tick;
+    }
+
+    /**
+     * @brief Record an access to page idx for LRU eviction (credited to its unit head).
+     * @param idx Valid page index.
+     */
+    void touch(int idx) {
+        pages[unit_head(idx)].last_access = ++access_tick;
+    }
+
+    /**
+     * @brief Release the RAM buffer of a residency unit and reset its page descriptors.
+     * @param head Head page index.
+     */
+    void reset_unit(int head) {
+        const size_t n = unit_len(head);
+        log_release(head);
+        bump_generation(head);
+        mrc_forget(head);
+        for (size_t k = 0; k < n; ++k) access_log(ACCESS_LOG_FREE, head + (int)k, 0);
+        if (pages[head].ram_addr) free(pages[head].ram_addr);
+        for (size_t k = 0; k < n; ++k) {
+            VMPage& page = pages[head + k];
+            page.ram_addr = nullptr;
+            page.in_ram = false;
+            page.allocated = false;
+            page.dirty = false;
+            page.zero_filled = true;
+            page.is_heap = false;
+            page.extent_head = -1;
+            page.extent_len = 0;
+            page.last_access = ++access_tick;
+            if (TagStats* ts = tag_slot(page.owner_tag)) ts->pages--;
+            page.owner_tag = 0;
+            page.io_tag = 0;
+            page.pin_count = 0;
+        }
+    }
+
     /**
      * @brief Swap a page out to disk if dirty; optionally force write.
      * @param idx Page index.
@@ -705,22 +3205,47 @@ private:
      */
     bool swap_out(int idx, bool force = false) {
         if (!valid_index(idx)) return false;
-        VMPage& page = pages[idx];
+        const int head = unit_head(idx);
+        VMPage& page = pages[head];
         if (!page.allocated) return false;
         if (!page.in_ram || !page.ram_addr) return true;
-
-        if (page.dirty || force) {
-            swap_write.seek(page.swap_offset);
-            size_t written = swap_write.write(page.ram_addr, page_size);
-            swap_write.flush();
-            (void)written;
-            page.dirty = false;
+        const uint32_t t0 = op_start();
+        uint32_t written_bytes = 0;
+        bool wrote = false; // only write-backs feed the swap_out latency histogram
+
+        // Extents are written as one sequential block covering all member pages.
+        const size_t n = unit_len(head);
+        bool dirty = false;
+        bool zero = true;
+        for (size_t k = 0; k < n; ++k) {
+            dirty = dirty || pages[head + k].dirty;
+            zero  = zero && pages[head + k].zero_filled;
+        }
+        if (zero && !force) {
+            // Content is known zero; swap_in() regenerates it without reading the slot.
+        } else if (dirty || (force && !log_has_copy(head))) {
+            size_t written = 0;
+            if (!SWAP_LOG) {
+                written = backend->write(page.swap_offset, page.ram_addr, n * page_size);
+            } else if (!log_write_unit(head, written)) {
+                op_done(TRACE_SWAP_OUT, head, 0, t0, TRACE_REASON_NONE, false);
+                return false; // log full: keep the RAM copy
+            }
+            backend->flush();
+            written_bytes = (uint32_t)written;
+            wrote = true;
+            if (TagStats* ts = tag_slot(page.io_tag)) ts->writebacks++;
         }
-        if (page.can_free_ram) {
+        for (size_t k = 0; k < n; ++k) pages[head + k].dirty = false;
+        bump_generation(head);
+        if (page.can_free_ram && !page.pin_count) {
             free(page.ram_addr);
-            page.ram_addr = nullptr;
-            page.in_ram = false;
+            for (size_t k = 0; k < n; ++k) {
+                pages[head + k].ram_addr = nullptr;
+                pages[head + k].in_ram = false;
+            }
         }
+        op_done(TRACE_SWAP_OUT, head, written_bytes, t0, TRACE_REASON_NONE, wrote);
         return true;
     }
 
@@ -731,19 +3256,37 @@ private:
      */
     bool swap_in(int idx) {
         if (!valid_index(idx)) return false;
-        VMPage& page = pages[idx];
+        const int head = unit_head(idx);
+        VMPage& page = pages[head];
         if (!page.allocated) return false;
+        const uint32_t t0 = op_start();
+        uint32_t read_bytes = 0;
+        const size_t n = unit_len(head);
+        bool zero = true;
+        for (size_t k = 0; k < n; ++k) zero = zero && pages[head + k].zero_filled;
+        if (SWAP_LOG && !log_has_copy(head)) zero = true; // never written back
         if (!page.in_ram || !page.ram_addr) {
-            // Allocate RAM buffer with eviction fallback
-            page.ram_addr = alloc_ram_buffer_with_eviction();
-            if (!page.ram_addr) return false;
-            page.in_ram = true;
-        }
-        swap_read.seek(page.swap_offset);
-        size_t readed = swap_read.read(page.ram_addr, page_size);
-        (void)readed;
+            if (!zero && !io_permitted()) return false;
+            // Allocate RAM buffer with eviction fallback (one buffer for a whole extent)
+            uint8_t* buf = alloc_ram_buffer_with_eviction(n * page_size);
+            if (!buf) return false;
+            for (size_t k = 0; k < n; ++k) {
+                pages[head + k].ram_addr = buf + k * page_size;
+                pages[head + k].in_ram = true;
+            }
+        }
+        if (zero) {
+            // Discarded or never-written slot: no need to touch the swap file.
+            memset(page.ram_addr, 0, n * page_size);
+        } else {
+            size_t readed = backend->read(page.swap_offset, page.ram_addr, n * page_size);
+            read_bytes = (uint32_t)readed;
+        }
         page.last_access = ++access_tick;
-        page.dirty = false;
+        for (size_t k = 0; k < n; ++k) pages[head + k].dirty = false;
+        bump_generation(head);
+        if (TagStats* ts = tag_slot(page.io_tag)) ts->faults++;
+        op_done(TRACE_SWAP_IN, head, read_bytes, t0);
         return true;
     }
 
@@ -787,11 +3330,16 @@ private:
     /**
      * @brief Mark entire page dirty.
      * @param idx Page index.
+     *
+     * @details Also clears zero_filled, since swap_out() skips the write-back of a zero page.
      */
     void mark_dirty(int idx) {
         if (!valid_index(idx)) return;
         VMPage& page = pages[idx];
-        if (page.allocated) page.dirty = true;
+        if (page.allocated) {
+            page.dirty = true;
+            page.zero_filled = false;
+        }
     }
 
     /**
@@ -829,30 +3377,40 @@ private:
      */
     bool free_page(int idx, bool wipe = false) {
         if (!valid_index(idx)) return false;
-        VMPage& page = pages[idx];
+        const int head = unit_head(idx);
+        VMPage& page = pages[head];
         if (!page.allocated) return true;
 
         if (page.in_ram && page.ram_addr) {
-            if (!wipe) swap_out(idx, false);
+            if (!wipe) swap_out(head, false);
         }
 
-        if (wipe) {
+        if (wipe && (!SWAP_LOG || log_has_copy(head))) {
             uint8_t zero[VM_PAGE_SIZE] = {0};
-            swap_write.seek(page.swap_offset);
-            swap_write.write(zero, page_size);
-            swap_write.flush();
+            for (size_t k = 0; k < unit_len(head); ++k)
+                backend->write(pages[head + k].swap_offset, zero, page_size);
+            backend->flush();
         }
 
-        if (page.ram_addr) {
-            free(page.ram_addr);
-            page.ram_addr = nullptr;
-        }
-        page.in_ram = false;
-        page.allocated = false;
-        page.dirty = false;
-        page.zero_filled = true;
-        page.is_heap = false;
-        page.last_access = ++access_tick;
+        reset_unit(head);
+        return true;
+    }
+
+    /**
+     * @brief Free a page without faulting it in or writing it back.
+     * @param idx Page index.
+     * @return True on success.
+     *
+     * @details The RAM buffer (if any) is released and the swap slot is marked as
+     *          zero, so neither this call nor a later reuse of the slot performs I/O.
+     *          Use when the page content is no longer needed. Discarding any page of an
+     *          extent discards the whole extent.
+     */
+    bool discard_page(int idx) {
+        if (!valid_index(idx)) return false;
+        const int head = unit_head(idx);
+        if (!pages[head].allocated) return true;
+        reset_unit(head);
         return true;
     }
 
@@ -884,7 +3442,7 @@ private:
     /**
      * @brief Internal pointer acquisition.
      * @param page_idx Page index.
-     * @param offset Offset within page.
+     * @param offset Offset within page (may run to the end of the page's extent).
      * @param mark_dirty_flag Whether to mark page dirty.
      * @return Pointer or nullptr.
      */
@@ -895,9 +3453,14 @@ private:
         if (!page.in_ram) {
             if (!swap_in(page_idx)) return nullptr;
         }
-        if (offset >= page_size) return nullptr;
-        page.last_access = ++access_tick;
-        if (mark_dirty_flag) page.dirty = true;
+        if (offset >= span_bytes(page_idx)) return nullptr;
+        touch(page_idx);
+        mrc_access(unit_head(page_idx));
+        access_log(mark_dirty_flag ? ACCESS_LOG_WRITE : ACCESS_LOG_READ, page_idx, offset);
+        if (mark_dirty_flag) {
+            page.dirty = true;
+            page.zero_filled = false;
+        }
         return page.ram_addr + offset;
     }
 
@@ -919,6 +3482,20 @@ private:
         return false;
     }
 
+    /**
+     * @brief Allocate an extent of count consecutive pages (wrapper over alloc_extent_ex).
+     * @param out_idx Output head page index.
+     * @param count Number of pages.
+     * @param opts Allocation options.
+     * @return True on success, false on failure.
+     */
+    bool extent_alloc(int& out_idx, size_t count, const AllocOptions& opts) {
+        int idx = -1;
+        if (!alloc_extent_ex(count, opts, &idx)) return false;
+        out_idx = idx;
+        return true;
+    }
+
     /**
      * @brief Allocate a page with default options (wrapper over alloc_page_ex).
      * @param out_idx Output page index.
@@ -938,6 +3515,15 @@ private:
         return free_page(idx, wipe);
     }
 
+    /**
+     * @brief Discard a page (wrapper over discard_page).
+     * @param idx Page index.
+     * @return True on success.
+     */
+    bool page_discard(int idx) {
+        return discard_page(idx);
+    }
+
     /**
      * @brief Get read-only pointer to page data (wrapper over get_read_ptr).
      * @param idx Page index.
@@ -982,16 +3568,20 @@ private:
      * @brief Allocate a small block from heap pages (wrapper over heap_alloc).
      * @param size Requested payload size.
      * @param align Alignment (passed through but may be ignored by heap_alloc).
-     * @param out_page Output page index.
-     * @param out_off Output payload offset.
+     * @param out_page Output page index (handle pseudo index when a handle was assigned).
+     * @param out_off Output payload offset (0 for handles).
      * @param out_alloc_size Output actual allocated size.
+     * @param hint Preferred page: stored page index of a related block (-1 = none).
      * @return True on success.
      */
-    bool small_alloc(size_t size, size_t align, int& out_page, size_t& out_off, size_t& out_alloc_size) {
+    bool small_alloc(size_t size, size_t align, int& out_page, size_t& out_off, size_t& out_alloc_size,
+                     int hint = -1) {
         int pg = -1;
         size_t off = 0;
         size_t sz = 0;
-        if (heap_alloc(size, align, &pg, &off, &sz)) {
+        if (heap_alloc(size, align, &pg, &off, &sz, hint)) {
+            charge_block(pg, off, current_tag);
+            attach_handle(pg, off);
             out_page = pg;
             out_off = off;
             out_alloc_size = sz;
@@ -1001,32 +3591,163 @@ private:
     }
 
     /**
-     * @brief Free a small block (wrapper over heap_free).
+     * @brief Make a freshly allocated small block relocatable if a handle is available.
+     * @param page In: physical heap page (resident); out: handle pseudo index if one was assigned.
+     * @param off In: physical payload offset; out: 0 if a handle was assigned.
+     *
+     * @details Without a free handle the block stays pinned at its physical location.
+     */
+    void attach_handle(int& page, size_t& off) {
+        for (size_t h = 0; h < HANDLE_COUNT; ++h) {
+            if (handles[h].page >= 0) continue;
+            handles[h].page = page;
+            handles[h].offset = (uint32_t)off;
+            reinterpret_cast<BlockHeader*>(pages[page].ram_addr + off - BH_SIZE)->reserved = (uint16_t)(h + 1);
+            page = (int)(page_count + h);
+            off = 0;
+            return;
+        }
+    }
+
+    /**
+     * @brief Allocate many small blocks of the same size in as few heap page visits as possible.
+     * @param size Requested payload size of each block.
+     * @param count Number of blocks.
+     * @param out_pages Output page indices (handle pseudo indices where handles were assigned).
+     * @param out_offs Output payload offsets.
+     * @return True if all 'count' blocks were allocated; on failure nothing stays allocated.
+     *
+     * @details Picks a heap page from the free-space summary like heap_alloc(), then carves as
+     * many blocks as fit from it with heap_alloc_run() before moving to the next page, so N
+     * blocks cost one scan and at most one fault per page used instead of N of each.
+     */
+    bool small_alloc_batch(size_t size, size_t count, int* out_pages, size_t* out_offs) {
+        const size_t need = align_up(size);
+        if (need > heap_max_payload()) return false;
+        size_t done = 0;
+        while (done < count) {
+            const uint32_t t0 = op_start();
+            int pick = -1;
+            for (size_t i = 0; i < page_count; ++i) {
+                const VMPage& pg = pages[i];
+                if (!pg.allocated || !pg.is_heap || pg.heap_largest_free < need) continue;
+                if (pg.in_ram && pg.ram_addr) { pick = (int)i; break; }
+                if (pick < 0) pick = (int)i;
+            }
+            if (pick < 0 || !ensure_heap_header(pick)) {
+                if (!alloc_heap_page(&pick)) break;
+            }
+            const size_t got = heap_alloc_run(pick, need, count - done, out_offs + done);
+            if (got == 0) break;
+            op_done(TRACE_HEAP_ALLOC, pick, (uint32_t)(got * need), t0);
+            for (size_t j = done; j < done + got; ++j) {
+                out_pages[j] = pick;
+                charge_block(pick, out_offs[j], current_tag);
+                attach_handle(out_pages[j], out_offs[j]);
+            }
+            done += got;
+        }
+        if (done < count) {
+            small_free_batch(out_pages, out_offs, done);
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Free many small blocks, visiting each heap page once.
+     * @param in_pages Page indices (or handle pseudo indices); freed entries are set to -1.
+     * @param in_offs Payload offsets.
+     * @param count Number of entries (entries that are already -1 are skipped).
+     *
+     * @details Blocks are freed grouped by physical page in order of first appearance, so a
+     * page that was swapped out is faulted in at most once and is released right after its
+     * last block instead of being revisited.
+     */
+    void small_free_batch(int* in_pages, size_t* in_offs, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            if (in_pages[i] < 0) continue;
+            const int phys = block_page(in_pages[i]);
+            for (size_t j = i; j < count; ++j) {
+                if (in_pages[j] < 0 || block_page(in_pages[j]) != phys) continue;
+                small_free(in_pages[j], in_offs[j]);
+                in_pages[j] = -1;
+            }
+        }
+    }
+
+    /**
+     * @brief Allocate storage for one object: a small block if it fits, otherwise a dedicated extent.
+     * @param size Object size in bytes.
+     * @param align Alignment (passed to small_alloc).
+     * @param out_page Output page index.
+     * @param out_off Output payload offset (0 for extents).
+     * @param hint Preferred heap page for small objects (stored page index, -1 = none).
+     * @return True on success.
+     */
+    bool object_alloc(size_t size, size_t align, int& out_page, size_t& out_off, int hint = -1) {
+        size_t alloc_sz = 0;
+        if (size <= heap_max_payload()) return small_alloc(size, align, out_page, out_off, alloc_sz, hint);
+        AllocOptions opts = default_alloc_options;
+        opts.zero_on_alloc = true;
+        opts.reuse_swap_data = false;
+        if (!extent_alloc(out_page, (size + page_size - 1) / page_size, opts)) return false;
+        out_off = 0;
+        return true;
+    }
+
+    /**
+     * @brief Free storage obtained from object_alloc().
      * @param page_idx Page index.
      * @param payload_off Payload offset.
      */
+    void object_free(int page_idx, size_t payload_off) {
+        if (is_handle(page_idx)) { small_free(page_idx, payload_off); return; }
+        if (!valid_index(page_idx)) return;
+        if (pages[page_idx].is_heap) small_free(page_idx, payload_off);
+        else discard_page(page_idx);
+    }
+
+    /**
+     * @brief Free a small block (wrapper over heap_free; releases its handle if any).
+     * @param page_idx Page index (or handle pseudo index).
+     * @param payload_off Payload offset.
+     */
     void small_free(int page_idx, size_t payload_off) {
+        if (is_handle(page_idx)) {
+            HeapHandle& h = handles[page_idx - page_count];
+            const int phys = h.page;
+            const size_t phys_off = h.offset + payload_off;
+            h.page = -1;
+            heap_free(phys, phys_off);
+            return;
+        }
         heap_free(page_idx, payload_off);
     }
 
     /**
      * @brief Get read-only pointer to small-block payload.
-     * @param page_idx Page index.
+     * @param page_idx Page index (or handle pseudo index).
      * @param payload_off Payload offset.
      * @return Pointer or nullptr.
      */
     void* small_read_ptr(int page_idx, size_t payload_off) {
+        resolve_block(page_idx, payload_off);
         return get_read_ptr(page_idx, payload_off);
     }
 
     /**
      * @brief Get writable pointer to small-block payload.
-     * @param page_idx Page index.
+     * @param page_idx Page index (or handle pseudo index).
      * @param payload_off Payload offset.
      * @return Pointer or nullptr.
      */
     void* small_write_ptr(int page_idx, size_t payload_off) {
-        return get_write_ptr(page_idx, payload_off);
+        resolve_block(page_idx, payload_off);
+        void* p = get_write_ptr(page_idx, payload_off);
+        if (TAG_COUNT && p && pages[page_idx].is_heap) // the next write-back of this heap page is charged to the writer
+            pages[page_idx].io_tag = (uint8_t)reinterpret_cast<BlockHeader*>(static_cast<uint8_t*>(p) - BH_SIZE)->tag;
+        return p;
     }
 
     /**
@@ -1050,13 +3771,17 @@ private:
         if (!small_alloc(new_min_size, 1, np, noff, nsize)) {
             return false;
         }
-        // Copy data from old to new
+        // Copy data from old to new; the old block is pinned so loading the new one cannot evict it
         size_t to_copy = std::min(copy_bytes, nsize);
         if (to_copy > 0) {
-            void* old_ptr = small_read_ptr(old_page, old_off);
-            void* new_ptr = small_write_ptr(np, noff);
-            if (old_ptr && new_ptr) {
-                memcpy(new_ptr, old_ptr, to_copy);
+            const int pinned = pin_unit(old_page);
+            void* old_ptr = pinned >= 0 ? small_read_ptr(old_page, old_off) : nullptr;
+            void* new_ptr = old_ptr ? small_write_ptr(np, noff) : nullptr;
+            if (old_ptr && new_ptr) memcpy(new_ptr, old_ptr, to_copy);
+            if (pinned >= 0) unpin_unit(pinned);
+            if (!old_ptr || !new_ptr) {
+                small_free(np, noff);
+                return false;
             }
         }
         // Free old block
@@ -1069,6 +3794,188 @@ private:
     }
 };
 
+/**
+ * @brief RAII helper: charges allocations made in its scope to an accounting tag.
+ *
+ * @details Restores the previous tag on destruction, so scopes nest. Example:
+ * @code
+ * static const uint8_t kNet = VMManager::instance().register_tag("net");
+ * { VMTagScope tag(kNet); rx_queue.reserve(64); }
+ * @endcode
+ */
+class VMTagScope {
+public:
+    /// Make tag current until the scope ends.
+    explicit VMTagScope(uint8_t tag) : prev_(VMManager::instance().set_tag(tag)) {}
+    ~VMTagScope() { VMManager::instance().set_tag(prev_); }
+    VMTagScope(const VMTagScope&) = delete;
+    VMTagScope& operator=(const VMTagScope&) = delete;
+
+private:
+    uint8_t prev_; ///< Tag to restore.
+};
+
+/**
+ * @class VMLockSet
+ * @brief Real-time working set: storage declared here is faulted in and pinned, so accessing it
+ * never blocks on swap I/O.
+ *
+ * @details Declare containers, VM pointers or page indices with add() / add_page(), then call
+ * lock(). lock() checks the RAM budget before touching anything: the set's distinct pages (whole
+ * extents) must fit its own max_frames, and together with pages already pinned by other sets they
+ * must fit VMManager::pin_budget(). It then faults the pages in and pins them; if any step fails,
+ * nothing stays pinned. Pinned pages are never evicted, released by flushes or moved by
+ * compact_step(). Pins are per page: storage added after lock() (push_back into a new chunk,
+ * string growth into another block) is covered only after the next lock(). Freeing locked
+ * storage drops its pins. Use VMNoFaultScope to catch accesses outside the set.
+ *
+ * @code
+ * VMLockSet rt(6);                    // at most 6 pages
+ * rt.add(filter_taps).add(state);     // VMVector, VMArray, VMString, VMPtr, ...
+ * if (!rt.lock()) fatal("working set does not fit");
+ * for (;;) { VMNoFaultScope nf; control_step(); }
+ * @endcode
+ */
+class VMLockSet {
+public:
+    /**
+     * @brief Empty set.
+     * @param max_frames RAM budget of this set in pages (0 = only VMManager::pin_budget() applies).
+     */
+    explicit VMLockSet(size_t max_frames = 0) : max_frames_(max_frames) {}
+    ~VMLockSet() { unlock(); }
+    VMLockSet(const VMLockSet&) = delete;
+    VMLockSet& operator=(const VMLockSet&) = delete;
+
+    /**
+     * @brief Declare the storage of a container or VM pointer.
+     * @param c VMVector, VMPackedVector, VMArray, VMString, VMPtr, VMUniquePtr or VMSharedPtr.
+     * @return *this, for chaining.
+     */
+    template<typename C>
+    VMLockSet& add(const C& c) {
+        c.for_each_page([this](int idx) { add_page(idx); });
+        return *this;
+    }
+
+    /**
+     * @brief Declare a page (or block) index, e.g. from VMPtr::page_index().
+     * @param idx Stored page index; handle indices resolve to their heap page at lock().
+     * @return *this, for chaining.
+     */
+    VMLockSet& add_page(int idx) {
+        if (idx >= 0 && (size_t)idx < kSlots) declared_[idx / 8] |= (uint8_t)(1u << (idx % 8));
+        return *this;
+    }
+
+    /**
+     * @brief Declare count consecutive pages starting at first.
+     * @return *this, for chaining.
+     */
+    VMLockSet& add_pages(int first, size_t count) {
+        for (size_t k = 0; k < count; ++k) add_page(first + (int)k);
+        return *this;
+    }
+
+    /**
+     * @brief Check the budget, fault in and pin every declared page (re-locks if already locked).
+     * @return False if the manager is not started, the budget is exceeded or a page cannot be
+     *         loaded; nothing is pinned then.
+     */
+    bool lock() {
+        unlock();
+        auto& mgr = VMManager::instance();
+        if (!mgr.started) return false;
+        size_t need = 0, already = 0;
+        for (size_t idx = 0; idx < kSlots; ++idx) {
+            if (!(declared_[idx / 8] & (1u << (idx % 8)))) continue;
+            const int page = mgr.block_page((int)idx);
+            if (!mgr.valid_index(page) || !mgr.pages[page].allocated) continue;
+            const int head = mgr.unit_head(page);
+            if (heads_[head / 8] & (1u << (head % 8))) continue;
+            heads_[head / 8] |= (uint8_t)(1u << (head % 8));
+            need += mgr.unit_len(head);
+            if (mgr.pages[head].pin_count) already += mgr.unit_len(head);
+        }
+        if ((max_frames_ && need > max_frames_) || mgr.pinned_frames() - already + need > mgr.pin_budget()) {
+            memset(heads_, 0, sizeof(heads_));
+            return false;
+        }
+        for (size_t head = 0; head < VM_PAGE_COUNT; ++head) {
+            if (!(heads_[head / 8] & (1u << (head % 8)))) continue;
+            if (mgr.pin_unit((int)head) < 0) {
+                // Roll back the pins taken so far.
+                for (size_t h = 0; h < head; ++h)
+                    if (heads_[h / 8] & (1u << (h % 8))) mgr.unpin_unit((int)h);
+                memset(heads_, 0, sizeof(heads_));
+                return false;
+            }
+        }
+        frames_ = need;
+        locked_ = true;
+        return true;
+    }
+
+    /// Drop the pins (declarations are kept, so lock() can be called again).
+    void unlock() {
+        if (!locked_) return;
+        auto& mgr = VMManager::instance();
+        for (size_t head = 0; head < VM_PAGE_COUNT; ++head)
+            if (heads_[head / 8] & (1u << (head % 8))) mgr.unpin_unit((int)head);
+        memset(heads_, 0, sizeof(heads_));
+        frames_ = 0;
+        locked_ = false;
+    }
+
+    /// Unlock and forget all declarations.
+    void clear() {
+        unlock();
+        memset(declared_, 0, sizeof(declared_));
+    }
+
+    bool locked() const { return locked_; }   ///< True between a successful lock() and unlock().
+    size_t frames() const { return frames_; } ///< Pages pinned by this set.
+
+private:
+    static constexpr size_t kSlots = VM_PAGE_COUNT + VM_HANDLE_COUNT; ///< Page and handle indices.
+
+    uint8_t declared_[(kSlots + 7) / 8] = {};       ///< Declared stored indices.
+    uint8_t heads_[(VM_PAGE_COUNT + 7) / 8] = {};   ///< Unit heads pinned by lock().
+    size_t max_frames_;                             ///< Budget of this set (0 = none).
+    size_t frames_ = 0;                             ///< Pages pinned.
+    bool locked_ = false;                           ///< Pins held.
+};
+
+/**
+ * @brief RAII helper: marks a section that must not block on swap I/O.
+ *
+ * @details Inside the scope, a swap-in that would read the swap area, or an eviction that would
+ * have to write a dirty page back, is a violation: it is counted in
+ * VMManager::no_fault_violations() and, in a strict scope, refused instead of performed, so the
+ * access fails (containers and VMPtr throw std::runtime_error). Evictions prefer clean pages, and
+ * resident or never-written pages are served as usual. Non-strict scopes only count, which helps
+ * find the missing entries of a VMLockSet. Scopes nest; the innermost decides strictness.
+ */
+class VMNoFaultScope {
+public:
+    /// Enter a no-fault section (strict = refuse blocking I/O, else only count it).
+    explicit VMNoFaultScope(bool strict = true) : prev_strict_(VMManager::instance().no_fault_strict) {
+        auto& mgr = VMManager::instance();
+        mgr.no_fault_depth++;
+        mgr.no_fault_strict = strict;
+    }
+    ~VMNoFaultScope() {
+        auto& mgr = VMManager::instance();
+        mgr.no_fault_depth--;
+        mgr.no_fault_strict = prev_strict_;
+    }
+    VMNoFaultScope(const VMNoFaultScope&) = delete;
+    VMNoFaultScope& operator=(const VMNoFaultScope&) = delete;
+
+private:
+    bool prev_strict_; ///< Strictness of the enclosing scope.
+};
+
 /**
  * @class VMPtr
  * @brief Smart pointer for objects stored in virtual memory with pointer arithmetic and indexing.
@@ -1093,10 +4000,10 @@ public:
     /**
      * @brief Default constructor (null pointer).
      */
-    VMPtr() : page_idx_(-1), offset_(0) {}
+    VMPtr() : page_idx_(-1), offset_(0), frame_(nullptr), frame_gen_(0), frame_writable_(false) {}
 
     /**
-     * @brief Check if pointer references a valid virtual address range (index in range and offset fits page).
+     * @brief Check if pointer references a valid virtual address range (index in range and object fits its page or extent).
      * @return True if virtual position is well-formed.
      *
      * @note Allocation state is not required for validity. Pages may be lazily allocated later.
@@ -1104,8 +4011,11 @@ public:
     bool valid() const {
         const auto& mgr = VMManager::instance();
         if (page_idx_ == -1) return true; // lazy unallocated is valid
-        return mgr.valid_index(page_idx_)
-            && offset_ + sizeof(T) <= mgr.get_page_size();
+        int page = page_idx_;
+        size_t off = offset_;
+        mgr.resolve_block(page, off);
+        return mgr.valid_index(page)
+            && off + sizeof(T) <= mgr.span_bytes(page);
     }
 
     /**
@@ -1114,8 +4024,7 @@ public:
      * @throws std::runtime_error if invalid or on swap/ptr acquisition failure.
      */
     T& operator*() {
-        ensure_loaded();
-        return *ptr_write();
+        return *acquire_write();
     }
     /**
      * @brief Dereference pointer for read-only access (does not mark page dirty).
@@ -1123,8 +4032,7 @@ public:
      * @throws std::runtime_error if invalid or on swap/ptr acquisition failure.
      */
     const T& operator*() const {
-        ensure_loaded();
-        return *ptr_read();
+        return *acquire_read();
     }
 
     /**
@@ -1133,8 +4041,7 @@ public:
      * @throws std::runtime_error if invalid or on swap/ptr acquisition failure.
      */
     T* operator->() {
-        ensure_loaded();
-        return ptr_write();
+        return acquire_write();
     }
     /**
      * @brief Member access operator for read-only access.
@@ -1142,8 +4049,7 @@ public:
      * @throws std::runtime_error if invalid or on swap/ptr acquisition failure.
      */
     const T* operator->() const {
-        ensure_loaded();
-        return ptr_read();
+        return acquire_read();
     }
 
     /**
@@ -1152,8 +4058,7 @@ public:
      * @throws std::runtime_error if invalid or on swap/ptr acquisition failure.
      */
     T* get() {
-        ensure_loaded();
-        return ptr_write();
+        return acquire_write();
     }
     /**
      * @brief Get const raw pointer to object in RAM (read-only; does not mark page dirty).
@@ -1161,8 +4066,7 @@ public:
      * @throws std::runtime_error if invalid or on swap/ptr acquisition failure.
      */
     const T* get() const {
-        ensure_loaded();
-        return ptr_read();
+        return acquire_read();
     }
 
     /**
@@ -1219,12 +4123,13 @@ public:
             }
         }
         
-        // Free the VM storage
-        VMManager::instance().small_free(page_idx_, offset_);
+        // Free the VM storage (small block or dedicated extent)
+        VMManager::instance().object_free(page_idx_, offset_);
         
         // Mark as null
         page_idx_ = -1;
         offset_ = 0;
+        frame_ = nullptr;
     }
 
     /**
@@ -1360,15 +4265,70 @@ protected:
      * @note Protected to prevent unsafe direct use by end users.
      *       Intended for internal operations and arithmetic within VMPtr only.
      */
-    VMPtr(int page, size_t offset) : page_idx_(page), offset_(offset) {}
+    VMPtr(int page, size_t offset)
+        : page_idx_(page), offset_(offset), frame_(nullptr), frame_gen_(0), frame_writable_(false) {}
 
-    // Friend declaration for make_vm helper function
+    // Friend declarations for make_vm helper functions
     template<typename U, typename... Args>
     friend VMPtr<U> make_vm(Args&&... args);
+    template<typename U, typename V, typename... Args>
+    friend VMPtr<U> make_vm_near(const VMPtr<V>& near, Args&&... args);
+    template<typename U, typename... Args>
+    friend VMPtr<U> make_vm_in(VMAllocGroup& group, Args&&... args);
+    template<typename U>
+    friend VMPtr<U> make_vm_array(size_t n);
+    template<typename U, typename... Args>
+    friend void make_vm_batch(VMPtr<U>* out, size_t n, const Args&... args);
+
+    /**
+     * @brief Allocate storage and construct an object in place (backs the make_vm family).
+     * @param hint Preferred heap page (stored page index, -1 = none).
+     * @param args Constructor arguments.
+     * @return VMPtr<T> to the new object.
+     * @throws std::runtime_error If allocation or construction fails.
+     */
+    template<typename... Args>
+    static VMPtr create(int hint, Args&&... args) {
+        auto& mgr = VMManager::instance();
+
+        // Allocate storage from small heap (or a dedicated extent for objects larger than a block)
+        int page_idx = -1;
+        size_t offset = 0;
+        if (!mgr.object_alloc(sizeof(T), alignof(T), page_idx, offset, hint)) {
+            throw std::runtime_error("make_vm: failed to allocate storage");
+        }
+
+        // Get writable pointer to the allocated space
+        void* ptr = mgr.small_write_ptr(page_idx, offset);
+        if (!ptr) {
+            mgr.object_free(page_idx, offset);
+            throw std::runtime_error("make_vm: failed to acquire write pointer");
+        }
+
+        // Construct object in-place using placement new with perfect forwarding
+        try {
+            new(ptr) T(std::forward<Args>(args)...);
+        } catch (...) {
+            mgr.object_free(page_idx, offset);
+            throw;
+        }
+
+        return VMPtr(page_idx, offset);
+    }
 
 private:
+    friend class VMLockSet;
+
+    /// Pass the stored page index of the object to f (for VMLockSet).
+    template<typename F>
+    void for_each_page(F&& f) const {
+        if (page_idx_ >= 0) f(page_idx_);
+    }
+
     /**
-     * @brief Ensure the referenced storage is ready: small-block allocate if needed and load into RAM if not resident.
+     * @brief Ensure the referenced storage is ready: allocate if needed and load into RAM if not resident.
+     *
+     * @details Objects larger than a heap block get a dedicated extent, which is loaded as a unit.
      *
      * @throws std::runtime_error If allocation/swap-in fails.
      */
@@ -1378,23 +4338,25 @@ private:
         if (page_idx_ == -1) {
             int new_idx = -1;
             size_t new_off = 0;
-            size_t alloc_sz = 0;
-            if (!mgr.small_alloc(sizeof(T), alignof(T), new_idx, new_off, alloc_sz))
+            if (!mgr.object_alloc(sizeof(T), alignof(T), new_idx, new_off))
                 throw std::runtime_error("VMPtr: failed to heap-allocate storage");
             page_idx_ = new_idx;
             offset_   = new_off;
-        } else {
-            if (!mgr.valid_index(page_idx_))
-                throw std::runtime_error("VMPtr: page index out of range");
         }
-
-        // Ensure the object fits entirely inside a single page.
-        if (offset_ + sizeof(T) > mgr.get_page_size())
+        // Relocatable blocks are addressed through the handle table.
+        int page = page_idx_;
+        size_t off = offset_;
+        mgr.resolve_block(page, off);
+        if (!mgr.valid_index(page))
+            throw std::runtime_error("VMPtr: page index out of range");
+
+        // Ensure the object fits entirely inside its page or extent.
+        if (off + sizeof(T) > mgr.span_bytes(page))
             throw std::runtime_error("VMPtr: object straddles page boundary");
 
         // Load into RAM only if not resident.
-        if (!mgr.pages[page_idx_].in_ram || !mgr.pages[page_idx_].ram_addr) {
-            if (!mgr.page_prefetch(page_idx_))
+        if (!mgr.pages[page].in_ram || !mgr.pages[page].ram_addr) {
+            if (!mgr.page_prefetch(page))
                 throw std::runtime_error("VMPtr: failed to swap-in page");
         }
     }
@@ -1421,8 +4383,62 @@ private:
         return p;
     }
 
+    /**
+     * @brief Return the cached frame pointer if it is still valid for the requested access.
+     * @param write True for write intent (requires a cache filled by the write path).
+     * @return Cached pointer, or nullptr if the slow path must run.
+     *
+     * @details The cache is valid while the page's generation is unchanged: the pager renews it
+     *          whenever the frame is freed, replaced or cleaned, or compaction moves blocks out.
+     *          A write-filled cache therefore implies the page is still dirty and needs no further
+     *          bookkeeping. A released handle (block_page() == -1) never validates.
+     */
+    T* cached(bool write) const {
+        if (!frame_ || (write && !frame_writable_)) return nullptr;
+        auto& mgr = VMManager::instance();
+        const int page = mgr.block_page(page_idx_);
+        if (!mgr.valid_index(page) || mgr.pages[page].generation != frame_gen_) return nullptr;
+        mgr.touch(page);
+        return frame_;
+    }
+
+    /**
+     * @brief Writable pointer: cached fast path, otherwise load, mark dirty and refill the cache.
+     * @return Writable pointer to object.
+     * @throws std::runtime_error If allocation/swap-in/pointer acquisition fails.
+     */
+    T* acquire_write() const {
+        if (T* p = cached(true)) return p;
+        ensure_loaded();
+        T* p = ptr_write();
+        auto& mgr = VMManager::instance();
+        frame_ = p;
+        frame_gen_ = mgr.pages[mgr.block_page(page_idx_)].generation;
+        frame_writable_ = true;
+        return p;
+    }
+
+    /**
+     * @brief Read-only pointer: cached fast path, otherwise load and refill the cache.
+     * @return Read-only pointer to object.
+     * @throws std::runtime_error If allocation/swap-in/pointer acquisition fails.
+     */
+    const T* acquire_read() const {
+        if (const T* p = cached(false)) return p;
+        ensure_loaded();
+        const T* p = ptr_read();
+        auto& mgr = VMManager::instance();
+        frame_ = const_cast<T*>(p);
+        frame_gen_ = mgr.pages[mgr.block_page(page_idx_)].generation;
+        frame_writable_ = false;
+        return p;
+    }
+
     mutable int page_idx_;   ///< Index of page in VMManager (heap-allocated on demand).
     mutable size_t offset_;  ///< Offset inside the page (in bytes) to payload.
+    mutable T* frame_;             ///< Cached RAM address of the object (nullptr = no cache).
+    mutable uint32_t frame_gen_;   ///< Page generation frame_ was taken at.
+    mutable bool frame_writable_;  ///< True if frame_ came from the write path (page already dirty).
 };
 
 // -----------------------------------------------------------------------------
@@ -1440,8 +4456,9 @@ private:
  * @details
  * Creates a VMPtr<T> and constructs the object in-place using the provided arguments.
  * This provides a safer, smart-pointer-like workflow similar to std::make_unique.
- * The object is allocated from VMManager's shared heap pages and constructed using
- * placement new with perfect forwarding of arguments.
+ * The object is allocated from VMManager's shared heap pages (or, if larger than a heap
+ * block, from a dedicated multi-page extent) and constructed using placement new with
+ * perfect forwarding of arguments.
  *
  * Benefits over manual construction:
  *  - Exception-safe: automatically frees allocated memory if constructor throws
@@ -1465,32 +4482,478 @@ private:
  */
 template<typename T, typename... Args>
 VMPtr<T> make_vm(Args&&... args) {
+    return VMPtr<T>::create(-1, std::forward<Args>(args)...);
+}
+
+/**
+ * @brief Create an object in the same heap page as an existing one where possible.
+ * @tparam T Object type.
+ * @tparam U Type of the related object.
+ * @param near Related object (e.g. the record whose name string or child this is).
+ * @param args Constructor arguments.
+ * @return VMPtr<T> to the new object.
+ * @throws std::runtime_error If allocation or construction fails.
+ *
+ * @details The hinted page is used if it has a large enough free block; otherwise the normal
+ *          placement applies. Objects that are accessed together then share one page fault.
+ */
+template<typename T, typename U, typename... Args>
+VMPtr<T> make_vm_near(const VMPtr<U>& near, Args&&... args) {
+    return VMPtr<T>::create(near.page_index(), std::forward<Args>(args)...);
+}
+
+/**
+ * @brief Allocation group: a token that keeps successive allocations on the same heap page.
+ *
+ * @details Pass the same group to make_vm_in() for objects used together (a node and its
+ *          children, a record and its fields). Each allocation prefers the page of the group's
+ *          previous allocation; when that page is full the group follows the new placement.
+ *          The token is a single int in RAM and owns nothing.
+ */
+class VMAllocGroup {
+public:
+    VMAllocGroup() : hint_(-1) {}
+    /// Forget the current page (the next allocation is placed normally).
+    void reset() { hint_ = -1; }
+
+private:
+    int hint_; ///< Stored page index of the group's last allocation (-1 = none).
+
+    template<typename T, typename... Args>
+    friend VMPtr<T> make_vm_in(VMAllocGroup& group, Args&&... args);
+};
+
+/**
+ * @brief Create an object inside an allocation group (see VMAllocGroup).
+ * @tparam T Object type.
+ * @param group Group token; updated to the page the object landed on.
+ * @param args Constructor arguments.
+ * @return VMPtr<T> to the new object.
+ * @throws std::runtime_error If allocation or construction fails.
+ */
+template<typename T, typename... Args>
+VMPtr<T> make_vm_in(VMAllocGroup& group, Args&&... args) {
+    VMPtr<T> p = VMPtr<T>::create(group.hint_, std::forward<Args>(args)...);
+    group.hint_ = p.page_index();
+    return p;
+}
+
+/**
+ * @brief Allocate a contiguous VM array of n default-constructed elements.
+ * @tparam T Element type.
+ * @param n Number of elements (must be > 0).
+ * @return VMPtr<T> to element 0; use pointer arithmetic or operator[] for the others.
+ * @throws std::length_error If n is 0 or n * sizeof(T) overflows.
+ * @throws std::runtime_error If allocation or construction fails.
+ *
+ * @details
+ * Arrays that fit one heap block share heap pages; larger arrays get a dedicated extent of
+ * consecutive pages, so VMPtr arithmetic that carries into the next page index stays inside
+ * the array. The extent is resident as a unit and is swapped in with one sequential read.
+ * Trivially default-constructible types are zero-filled instead of constructed.
+ *
+ * @note Release with destroy_vm_array(p, n); VMPtr::destroy() would only destroy element 0.
+ */
+template<typename T>
+VMPtr<T> make_vm_array(size_t n) {
+    if (n == 0 || n > std::numeric_limits<size_t>::max() / sizeof(T))
+        throw std::length_error("make_vm_array: invalid element count");
     auto& mgr = VMManager::instance();
-    
-    // Allocate storage from small heap
+
     int page_idx = -1;
     size_t offset = 0;
-    size_t alloc_sz = 0;
-    if (!mgr.small_alloc(sizeof(T), alignof(T), page_idx, offset, alloc_sz)) {
-        throw std::runtime_error("make_vm: failed to allocate storage");
+    if (!mgr.object_alloc(n * sizeof(T), alignof(T), page_idx, offset))
+        throw std::runtime_error("make_vm_array: failed to allocate storage");
+
+    T* base = reinterpret_cast<T*>(mgr.small_write_ptr(page_idx, offset));
+    if (!base) {
+        mgr.object_free(page_idx, offset);
+        throw std::runtime_error("make_vm_array: failed to acquire write pointer");
+    }
+    if (std::is_trivially_default_constructible<T>::value) {
+        memset(static_cast<void*>(base), 0, n * sizeof(T));
+    } else {
+        size_t constructed = 0;
+        try {
+            for (; constructed < n; ++constructed) new(base + constructed) T();
+        } catch (...) {
+            while (constructed) base[--constructed].~T();
+            mgr.object_free(page_idx, offset);
+            throw;
+        }
     }
-    
-    // Get writable pointer to the allocated space
-    void* ptr = mgr.small_write_ptr(page_idx, offset);
-    if (!ptr) {
-        mgr.small_free(page_idx, offset);
-        throw std::runtime_error("make_vm: failed to acquire write pointer");
+    return VMPtr<T>(page_idx, offset);
+}
+
+/**
+ * @brief Destroy an array created by make_vm_array() and free its storage.
+ * @tparam T Element type.
+ * @param p Pointer to element 0 (becomes null).
+ * @param n Element count passed to make_vm_array().
+ *
+ * @details Non-trivial elements are destroyed in reverse order. Extent pages are discarded
+ *          without write-back.
+ */
+template<typename T>
+void destroy_vm_array(VMPtr<T>& p, size_t n) {
+    const int page_idx = p.page_index();
+    if (page_idx < 0) return;
+    auto& mgr = VMManager::instance();
+    if (!std::is_trivially_destructible<T>::value) {
+        T* base = reinterpret_cast<T*>(mgr.small_write_ptr(page_idx, p.page_offset()));
+        if (base) {
+            while (n) base[--n].~T();
+        }
     }
-    
-    // Construct object in-place using placement new with perfect forwarding
-    try {
-        new(ptr) T(std::forward<Args>(args)...);
-    } catch (...) {
-        mgr.small_free(page_idx, offset);
-        throw;
+    mgr.object_free(page_idx, p.page_offset());
+    p = VMPtr<T>();
+}
+
+/**
+ * @brief Destroy n objects and free their storage, visiting each heap page once.
+ * @tparam T Object type.
+ * @param ptrs Pointers to destroy (all become null; null entries are skipped).
+ * @param n Number of pointers.
+ *
+ * @details Works for any objects created with make_vm(), make_vm_batch() or their variants.
+ *          Destructors run first, then heap blocks are released grouped by page with
+ *          VMManager::small_free_batch(); extent-backed objects are discarded one by one.
+ */
+template<typename T>
+void destroy_vm_batch(VMPtr<T>* ptrs, size_t n) {
+    auto& mgr = VMManager::instance();
+    constexpr size_t kChunk = 32;
+    int pg[kChunk];
+    size_t off[kChunk];
+    size_t cnt = 0;
+    for (size_t i = 0; i < n; ++i) {
+        VMPtr<T>& p = ptrs[i];
+        const int page_idx = p.page_index();
+        if (page_idx < 0) continue;
+        if (!std::is_trivially_destructible<T>::value) {
+            T* obj = reinterpret_cast<T*>(mgr.small_write_ptr(page_idx, p.page_offset()));
+            if (obj) obj->~T();
+        }
+        if (mgr.is_handle(page_idx) || mgr.pages[page_idx].is_heap) {
+            pg[cnt] = page_idx;
+            off[cnt] = p.page_offset();
+            if (++cnt == kChunk) {
+                mgr.small_free_batch(pg, off, cnt);
+                cnt = 0;
+            }
+        } else {
+            mgr.object_free(page_idx, p.page_offset());
+        }
+        p = VMPtr<T>();
     }
-    
-    return VMPtr<T>(page_idx, offset);
+    mgr.small_free_batch(pg, off, cnt);
+}
+
+/**
+ * @brief Create n separate objects, each constructed from copies of the same arguments.
+ * @tparam T Object type.
+ * @param out Receives the n new pointers (each released individually or with destroy_vm_batch()).
+ * @param n Number of objects.
+ * @param args Constructor arguments (not forwarded: every object gets its own copy).
+ * @throws std::runtime_error If allocation or construction fails (nothing stays allocated).
+ *
+ * @details Objects that fit a heap block are allocated with VMManager::small_alloc_batch(),
+ *          which fills one heap page at a time instead of scanning the heap for every object.
+ *          Larger objects fall back to one extent each.
+ */
+template<typename T, typename... Args>
+void make_vm_batch(VMPtr<T>* out, size_t n, const Args&... args) {
+    auto& mgr = VMManager::instance();
+    if (sizeof(T) > mgr.heap_max_payload()) {
+        size_t made = 0;
+        try {
+            for (; made < n; ++made) out[made] = make_vm<T>(args...);
+        } catch (...) {
+            while (made) out[--made].destroy();
+            throw;
+        }
+        return;
+    }
+    constexpr size_t kChunk = 32; // stack arrays: 32 * (int + size_t)
+    int pg[kChunk];
+    size_t off[kChunk];
+    size_t made = 0;
+    while (made < n) {
+        const size_t cnt = std::min(kChunk, n - made);
+        if (!mgr.small_alloc_batch(sizeof(T), cnt, pg, off)) {
+            destroy_vm_batch(out, made);
+            throw std::runtime_error("make_vm_batch: failed to allocate storage");
+        }
+        size_t built = 0;
+        try {
+            for (; built < cnt; ++built) {
+                void* ptr = mgr.small_write_ptr(pg[built], off[built]);
+                if (!ptr) throw std::runtime_error("make_vm_batch: failed to acquire write pointer");
+                new(ptr) T(args...);
+                out[made + built] = VMPtr<T>(pg[built], off[built]);
+                pg[built] = -1;
+            }
+        } catch (...) {
+            mgr.small_free_batch(pg, off, cnt);
+            destroy_vm_batch(out, made + built);
+            throw;
+        }
+        made += cnt;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Owning smart pointers
+// -----------------------------------------------------------------------------
+
+/**
+ * @brief Move-only owning pointer to an object in virtual memory.
+ * @tparam T Object type.
+ *
+ * @details Wraps a VMPtr<T> and calls destroy() when it goes out of scope or is reset, so the
+ *          destructor runs and the heap block is returned without user bookkeeping. Adds no
+ *          RAM beyond the wrapped VMPtr. Create with make_vm_unique<T>(...).
+ */
+template<typename T>
+class VMUniquePtr {
+public:
+    /// Null pointer.
+    VMUniquePtr() {}
+    /// Adopt an object created with make_vm<T>() (takes over its lifetime).
+    explicit VMUniquePtr(VMPtr<T> p) : ptr_(p) {}
+    VMUniquePtr(const VMUniquePtr&) = delete;
+    VMUniquePtr& operator=(const VMUniquePtr&) = delete;
+    /// Move constructor (source becomes null).
+    VMUniquePtr(VMUniquePtr&& other) noexcept : ptr_(other.ptr_) { other.ptr_ = VMPtr<T>(); }
+    /// Move assignment (destroys the currently owned object).
+    VMUniquePtr& operator=(VMUniquePtr&& other) noexcept {
+        if (this != &other) {
+            reset();
+            ptr_ = other.ptr_;
+            other.ptr_ = VMPtr<T>();
+        }
+        return *this;
+    }
+    /// Destroys the owned object and frees its storage.
+    ~VMUniquePtr() { reset(); }
+
+    /// Destroy the owned object (if any) and become null.
+    void reset() { ptr_.destroy(); }
+
+    /**
+     * @brief Give up ownership without destroying the object.
+     * @return Non-owning VMPtr; the caller becomes responsible for destroy().
+     */
+    VMPtr<T> release() {
+        VMPtr<T> p = ptr_;
+        ptr_ = VMPtr<T>();
+        return p;
+    }
+
+    /// Non-owning view of the managed object.
+    const VMPtr<T>& vm_ptr() const { return ptr_; }
+
+    /// True if an object is owned.
+    explicit operator bool() const { return ptr_.page_index() >= 0; }
+
+    /**
+     * @brief Write access (marks page dirty).
+     * @throws std::runtime_error If null or on swap failure.
+     */
+    T& operator*() { return *checked(); }
+    /// Read-only access. @throws std::runtime_error If null or on swap failure.
+    const T& operator*() const { return *checked(); }
+    /// Write member access. @throws std::runtime_error If null or on swap failure.
+    T* operator->() { return checked().operator->(); }
+    /// Read-only member access. @throws std::runtime_error If null or on swap failure.
+    const T* operator->() const { return checked().operator->(); }
+
+    /// Swap ownership with another pointer.
+    void swap(VMUniquePtr& other) noexcept { std::swap(ptr_, other.ptr_); }
+
+private:
+    VMPtr<T> ptr_; ///< Owned object (page index -1 = null).
+
+    friend class VMLockSet;
+    /// Pass the owned object's page index to f (for VMLockSet).
+    template<typename F>
+    void for_each_page(F&& f) const {
+        if (ptr_.page_index() >= 0) f(ptr_.page_index());
+    }
+
+    VMPtr<T>& checked() {
+        if (ptr_.page_index() < 0) throw std::runtime_error("VMUniquePtr: null dereference");
+        return ptr_;
+    }
+    const VMPtr<T>& checked() const {
+        if (ptr_.page_index() < 0) throw std::runtime_error("VMUniquePtr: null dereference");
+        return ptr_;
+    }
+};
+
+namespace detail {
+
+/// Tag selecting the forwarding constructor of SharedBlock.
+struct shared_init_t {};
+
+/**
+ * @brief Object plus intrusive reference count, stored together in one VM block.
+ * @tparam T Object type.
+ *
+ * @details The 8-byte header (count + padding to keep the payload 8-byte aligned) sits directly
+ *          before the object, so a VMSharedPtr needs no RAM-side control block.
+ */
+template<typename T>
+struct SharedBlock {
+    uint32_t refs;     ///< Number of VMSharedPtr owners.
+    uint32_t reserved; ///< Padding (keeps value 8-byte aligned).
+    T value;           ///< Managed object.
+
+    template<typename... Args>
+    explicit SharedBlock(shared_init_t, Args&&... args)
+        : refs(1), reserved(0), value(std::forward<Args>(args)...) {}
+};
+
+} // namespace detail
+
+/**
+ * @brief Reference-counted owning pointer to an object in virtual memory.
+ * @tparam T Object type.
+ *
+ * @details The reference count lives in VM next to the object (see detail::SharedBlock), so
+ *          copying or destroying a VMSharedPtr writes to that page; the RAM footprint is a single
+ *          VMPtr. The last owner runs the destructor and frees the block. Not thread-safe.
+ *          Create with make_vm_shared<T>(...).
+ */
+template<typename T>
+class VMSharedPtr {
+    using Block = detail::SharedBlock<T>;
+
+public:
+    /// Null pointer.
+    VMSharedPtr() {}
+    /// Copy constructor (shares ownership).
+    VMSharedPtr(const VMSharedPtr& other) : block_(other.block_) { retain(); }
+    /// Move constructor (source becomes null).
+    VMSharedPtr(VMSharedPtr&& other) noexcept : block_(other.block_) { other.block_ = VMPtr<Block>(); }
+    /// Copy assignment.
+    VMSharedPtr& operator=(const VMSharedPtr& other) {
+        if (this != &other) {
+            VMSharedPtr tmp(other);
+            swap(tmp);
+        }
+        return *this;
+    }
+    /// Move assignment.
+    VMSharedPtr& operator=(VMSharedPtr&& other) noexcept {
+        if (this != &other) {
+            reset();
+            block_ = other.block_;
+            other.block_ = VMPtr<Block>();
+        }
+        return *this;
+    }
+    /// Drops this owner; the last owner destroys the object.
+    ~VMSharedPtr() { reset(); }
+
+    /**
+     * @brief Drop ownership and become null.
+     *
+     * @details Never throws (it runs from the destructor and move assignment). If the count
+     * cannot be reached, because swap-in fails or a strict VMNoFaultScope refuses the fault,
+     * this owner is dropped without decrementing it: the object leaks instead of being freed
+     * while other owners may still use it.
+     */
+    void reset() noexcept {
+        if (block_.page_index() < 0) return;
+        bool last = false;
+        try {
+            Block* b = block_.get();
+            last = --b->refs == 0;
+        } catch (...) {
+        }
+        if (last) block_.destroy();
+        block_ = VMPtr<Block>();
+    }
+
+    /// Number of owners (0 if null; reads the count from VM).
+    long use_count() const {
+        return block_.page_index() < 0 ? 0 : (long)block_->refs;
+    }
+
+    /// True if an object is owned.
+    explicit operator bool() const { return block_.page_index() >= 0; }
+
+    /**
+     * @brief Write access (marks page dirty).
+     * @throws std::runtime_error If null or on swap failure.
+     */
+    T& operator*() { return checked()->value; }
+    /// Read-only access. @throws std::runtime_error If null or on swap failure.
+    const T& operator*() const { return checked()->value; }
+    /// Write member access. @throws std::runtime_error If null or on swap failure.
+    T* operator->() { return &checked()->value; }
+    /// Read-only member access. @throws std::runtime_error If null or on swap failure.
+    const T* operator->() const { return &checked()->value; }
+
+    /// Swap ownership with another pointer.
+    void swap(VMSharedPtr& other) noexcept { std::swap(block_, other.block_); }
+
+    /// Equality: same managed object.
+    bool operator==(const VMSharedPtr& other) const { return block_ == other.block_; }
+    bool operator!=(const VMSharedPtr& other) const { return !(*this == other); }
+
+private:
+    VMPtr<Block> block_; ///< Object plus refcount (page index -1 = null).
+
+    friend class VMLockSet;
+    /// Pass the shared block's page index to f (for VMLockSet).
+    template<typename F>
+    void for_each_page(F&& f) const {
+        if (block_.page_index() >= 0) f(block_.page_index());
+    }
+
+    template<typename U, typename... Args>
+    friend VMSharedPtr<U> make_vm_shared(Args&&... args);
+
+    /// Adopt a freshly created block (count already 1).
+    explicit VMSharedPtr(VMPtr<Block> b) : block_(b) {}
+
+    void retain() {
+        if (block_.page_index() >= 0) ++block_->refs;
+    }
+    VMPtr<Block>& checked() {
+        if (block_.page_index() < 0) throw std::runtime_error("VMSharedPtr: null dereference");
+        return block_;
+    }
+    const VMPtr<Block>& checked() const {
+        if (block_.page_index() < 0) throw std::runtime_error("VMSharedPtr: null dereference");
+        return block_;
+    }
+};
+
+/**
+ * @brief Create an object in VM owned by a VMUniquePtr.
+ * @tparam T Object type.
+ * @param args Constructor arguments.
+ * @return Owning pointer; the object is destroyed when it goes out of scope.
+ * @throws std::runtime_error If allocation or construction fails.
+ */
+template<typename T, typename... Args>
+VMUniquePtr<T> make_vm_unique(Args&&... args) {
+    return VMUniquePtr<T>(make_vm<T>(std::forward<Args>(args)...));
+}
+
+/**
+ * @brief Create a reference-counted object in VM (count and object share one block).
+ * @tparam T Object type.
+ * @param args Constructor arguments.
+ * @return Shared owning pointer with use_count() == 1.
+ * @throws std::runtime_error If allocation or construction fails.
+ */
+template<typename T, typename... Args>
+VMSharedPtr<T> make_vm_shared(Args&&... args) {
+    return VMSharedPtr<T>(make_vm<detail::SharedBlock<T>>(detail::shared_init_t(), std::forward<Args>(args)...));
 }
 
 // -----------------------------------------------------------------------------
@@ -1617,6 +5080,89 @@ private:
     ForwardIter _base; ///< Forward iterator one-past current reverse element.
 };
 
+/// True if v is a non-zero power of two.
+constexpr bool is_pow2(size_t v) { return v != 0 && (v & (v - 1)) == 0; }
+/// floor(log2(v)) for v >= 1.
+constexpr unsigned log2_floor(size_t v) { return v > 1 ? 1 + log2_floor(v >> 1) : 0; }
+
+/**
+ * @brief Compile-time mapping of an element index to (chunk, slot) for T packed into page chunks.
+ * @tparam T Element type.
+ *
+ * @details A chunk is kPagesPerChunk consecutive pages allocated as one extent (a single page
+ *          unless T is larger than a page). Elements never straddle a chunk. When the per-chunk
+ *          element count is a power of two, chunk_of()/slot_of() reduce to a shift and a mask.
+ *          Otherwise chunk_of() multiplies by a precomputed reciprocal and shifts; the reciprocal
+ *          is exact for every index below kMaxIndex (all pages filled), so no runtime division is
+ *          ever emitted.
+ */
+template<typename T>
+struct ChunkLayout {
+    static constexpr size_t   kPagesPerChunk = (sizeof(T) + VM_PAGE_SIZE - 1) / VM_PAGE_SIZE; ///< Pages per chunk.
+    static constexpr size_t   kChunkBytes    = kPagesPerChunk * VM_PAGE_SIZE;                 ///< Bytes per chunk.
+    static constexpr size_t   kMaxChunks     = VM_PAGE_COUNT / kPagesPerChunk;                ///< Chunks that fit in VM.
+
+    static_assert(kPagesPerChunk <= VM_PAGE_COUNT, "ChunkLayout: element larger than the whole VM");
+
+    static constexpr size_t   kPerChunk = kChunkBytes / sizeof(T);   ///< Elements per chunk.
+    static constexpr bool     kPow2     = is_pow2(kPerChunk);        ///< True if shift/mask indexing applies.
+    static constexpr unsigned kShift    = log2_floor(kPerChunk);     ///< log2(kPerChunk) when kPow2.
+    static constexpr size_t   kMask     = kPerChunk - 1;             ///< Slot mask when kPow2.
+
+    static constexpr uint64_t kMaxIndex   = (uint64_t)kMaxChunks * kPerChunk;               ///< Index bound for the reciprocal.
+    static constexpr unsigned kRecipShift = log2_floor((size_t)(kMaxIndex * kPerChunk)) + 1; ///< 2^shift > kMaxIndex * kPerChunk.
+    static constexpr uint64_t kRecip      = (((uint64_t)1 << kRecipShift) + kPerChunk - 1) / kPerChunk; ///< ceil(2^shift / kPerChunk).
+
+    static_assert(kMaxIndex < ((uint64_t)1 << 31), "ChunkLayout: index range too large for reciprocal indexing");
+
+    /// Chunk number holding element idx.
+    static constexpr size_t chunk_of(size_t idx) {
+        return kPow2 ? (idx >> kShift) : (size_t)(((uint64_t)idx * kRecip) >> kRecipShift);
+    }
+    /// Slot of element idx inside its chunk.
+    static constexpr size_t slot_of(size_t idx) {
+        return kPow2 ? (idx & kMask) : (idx - chunk_of(idx) * kPerChunk);
+    }
+};
+
+/**
+ * @brief Write-tracking element reference returned by the containers' ref() accessors.
+ * @tparam Container Owning container type (must provide cread() and operator[]).
+ * @tparam ValueType Element type.
+ *
+ * @details
+ * Reading through the proxy uses the container's read path and never marks the page dirty;
+ * only assignment (or an explicit modify()) goes through the write path. A page that is only
+ * scanned through ref() can therefore be evicted without a write-back.
+ */
+template<typename Container, typename ValueType>
+class ElementRef {
+public:
+    /// Construct for container and position.
+    ElementRef(Container* c, size_t pos) : _c(c), _pos(pos) {}
+
+    /// Read the element (does not mark dirty).
+    operator const ValueType&() const { return _c->cread(_pos); }
+    /// Read the element explicitly (does not mark dirty).
+    const ValueType& get() const { return _c->cread(_pos); }
+    /// Get a mutable reference (marks dirty).
+    ValueType& modify() const { return (*_c)[_pos]; }
+
+    /// Write the element (marks dirty).
+    ElementRef& operator=(const ValueType& v) { (*_c)[_pos] = v; return *this; }
+    /// Move-write the element (marks dirty).
+    ElementRef& operator=(ValueType&& v) { (*_c)[_pos] = std::move(v); return *this; }
+    /// Copy the referenced value of another proxy (reads other, writes this).
+    ElementRef& operator=(const ElementRef& other) { (*_c)[_pos] = other.get(); return *this; }
+
+    /// Position inside the container.
+    size_t pos() const { return _pos; }
+
+private:
+    Container* _c; ///< Container pointer.
+    size_t _pos;   ///< Logical element index.
+};
+
 } // namespace detail
 
 // -----------------------------------------------------------------------------
@@ -1646,9 +5192,10 @@ public:
     using const_iterator         = detail::GenericRandomAccessIterator<VMVector, T, true>;
     using reverse_iterator       = detail::GenericReverseIterator<iterator>;
     using const_reverse_iterator = detail::GenericReverseIterator<const_iterator>;
+    using element_ref            = detail::ElementRef<VMVector, T>; ///< Write-tracking proxy.
 
     /// Default constructor (starts in flat mode).
-    VMVector() : _chunk_capacity(VM_PAGE_SIZE / sizeof(T)), _chunk_count(0), _size(0),
+    VMVector() : _chunk_count(0), _size(0),
                  _flat_mode(true), _flat_page(-1), _flat_offset(0), _flat_capacity(0) {
         for (size_type i = 0; i < VM_PAGE_COUNT; ++i) {
             _chunks[i].page_idx = -1;
@@ -1664,7 +5211,7 @@ public:
 
     /// Move constructor.
     VMVector(VMVector&& other) noexcept
-        : _chunk_capacity(other._chunk_capacity), _chunk_count(other._chunk_count), _size(other._size),
+        : _chunk_count(other._chunk_count), _size(other._size),
           _flat_mode(other._flat_mode), _flat_page(other._flat_page), 
           _flat_offset(other._flat_offset), _flat_capacity(other._flat_capacity) {
         for (size_type i = 0; i < VM_PAGE_COUNT; ++i) {
@@ -1692,7 +5239,6 @@ public:
     VMVector& operator=(VMVector&& other) noexcept {
         if (this != &other) {
             clear();
-            _chunk_capacity = other._chunk_capacity;
             _size           = other._size;
             _chunk_count    = other._chunk_count;
             _flat_mode      = other._flat_mode;
@@ -1720,36 +5266,84 @@ public:
     // Element access (non-const -> write intent)
     /**
      * @brief Unchecked element access (write intent).
-     * @param idx Element index.
+     * @param idx Element index (not bounds-checked).
      * @return Reference.
+     * @throws std::runtime_error If the element's page cannot be loaded (e.g. refused in a
+     *         strict VMNoFaultScope).
      */
     reference operator[](size_type idx) {
         if (_flat_mode) {
             T* base = reinterpret_cast<T*>(VMManager::instance().small_write_ptr(_flat_page, _flat_offset));
+            if (!base) throw std::runtime_error("VMVector: failed to acquire write pointer");
             return base[idx];
         } else {
-            size_type chunk_num = idx / _chunk_capacity;
-            size_type offset    = idx % _chunk_capacity;
-            Chunk& ch = _chunks[chunk_num];
-            return *reinterpret_cast<T*>(VMManager::instance().page_write_ptr(ch.page_idx, offset * sizeof(T)));
+            Chunk& ch = _chunks[Layout::chunk_of(idx)];
+            size_type offset = Layout::slot_of(idx);
+            T* ptr = reinterpret_cast<T*>(VMManager::instance().page_write_ptr(ch.page_idx, offset * sizeof(T)));
+            if (!ptr) throw std::runtime_error("VMVector: failed to acquire write pointer");
+            return *ptr;
         }
     }
     /**
      * @brief Unchecked element access (read intent).
-     * @param idx Element index.
+     * @param idx Element index (not bounds-checked).
      * @return Const reference.
+     * @throws std::runtime_error If the element's page cannot be loaded.
      */
     const_reference operator[](size_type idx) const {
         if (_flat_mode) {
             const T* base = reinterpret_cast<const T*>(VMManager::instance().small_read_ptr(_flat_page, _flat_offset));
+            if (!base) throw std::runtime_error("VMVector: failed to acquire read pointer");
             return base[idx];
         } else {
-            size_type chunk_num = idx / _chunk_capacity;
-            size_type offset    = idx % _chunk_capacity;
-            const Chunk& ch = _chunks[chunk_num];
-            return *reinterpret_cast<const T*>(VMManager::instance().page_read_ptr(ch.page_idx, offset * sizeof(T)));
+            const Chunk& ch = _chunks[Layout::chunk_of(idx)];
+            size_type offset = Layout::slot_of(idx);
+            const T* ptr = reinterpret_cast<const T*>(VMManager::instance().page_read_ptr(ch.page_idx, offset * sizeof(T)));
+            if (!ptr) throw std::runtime_error("VMVector: failed to acquire read pointer");
+            return *ptr;
+        }
+    }
+    /**
+     * @brief Unchecked read-only element access, usable on non-const vectors (does not mark dirty).
+     * @param idx Element index.
+     * @return Const reference.
+     */
+    const_reference cread(size_type idx) const { return (*this)[idx]; }
+
+    /**
+     * @brief Write-tracking element access: reads do not mark dirty, assignment does.
+     * @param idx Element index.
+     * @return Proxy reference.
+     */
+    element_ref ref(size_type idx) { return element_ref(this, idx); }
+
+    /**
+     * @brief Read-only view of the contiguous run of elements starting at idx (does not mark dirty).
+     * @param idx First element index.
+     * @param count Output number of elements readable through the returned pointer.
+     * @return Pointer to element idx, or nullptr (count = 0) if idx >= size().
+     *
+     * @details The run ends at the end of the flat block or of the page holding idx.
+     *          The pointer is valid until the next VM access that may evict pages.
+     */
+    const T* read_span(size_type idx, size_type& count) const {
+        count = 0;
+        if (idx >= _size) return nullptr;
+        if (_flat_mode) {
+            const T* base = reinterpret_cast<const T*>(VMManager::instance().small_read_ptr(_flat_page, _flat_offset));
+            if (!base) return nullptr;
+            count = _size - idx;
+            return base + idx;
         }
+        const Chunk& ch = _chunks[Layout::chunk_of(idx)];
+        size_type offset = Layout::slot_of(idx);
+        if (offset >= ch.count) return nullptr;
+        const T* ptr = reinterpret_cast<const T*>(VMManager::instance().page_read_ptr(ch.page_idx, offset * sizeof(T)));
+        if (!ptr) return nullptr;
+        count = ch.count - offset;
+        return ptr;
     }
+
     /**
      * @brief Bounds-checked element access.
      * @param idx Index.
@@ -1795,7 +5389,7 @@ public:
     size_type size() const { return _size; }
     /// Current capacity in elements (sum of allocated chunks or flat capacity).
     size_type capacity() const { 
-        return _flat_mode ? _flat_capacity : (_chunk_count * _chunk_capacity); 
+        return _flat_mode ? _flat_capacity : (_chunk_count * Layout::kPerChunk); 
     }
 
     /**
@@ -1840,8 +5434,7 @@ public:
             }
         }
         // Paged mode (or transitioned to paged)
-        ensure_back_slot();
-        Chunk& ch = _chunks[_chunk_count - 1];
+        Chunk& ch = ensure_back_slot();
         T* ptr = reinterpret_cast<T*>(VMManager::instance().page_write_ptr(ch.page_idx, ch.count * sizeof(T)));
         new(ptr) T(value);
         ch.count++; _size++;
@@ -1866,8 +5459,7 @@ public:
             }
         }
         // Paged mode (or transitioned to paged)
-        ensure_back_slot();
-        Chunk& ch = _chunks[_chunk_count - 1];
+        Chunk& ch = ensure_back_slot();
         T* ptr = reinterpret_cast<T*>(VMManager::instance().page_write_ptr(ch.page_idx, ch.count * sizeof(T)));
         new(ptr) T(std::forward<Args>(args)...);
         ch.count++; _size++;
@@ -1899,22 +5491,25 @@ public:
     void pop_back() {
         if (_size == 0) throw std::out_of_range("VMVector::pop_back");
         if (_flat_mode) {
-            T* base = reinterpret_cast<T*>(VMManager::instance().small_write_ptr(_flat_page, _flat_offset));
-            base[_size - 1].~T();
+            if (!std::is_trivially_destructible<T>::value) {
+                T* base = reinterpret_cast<T*>(VMManager::instance().small_write_ptr(_flat_page, _flat_offset));
+                base[_size - 1].~T();
+            }
             _size--;
             return;
         }
-        // Paged mode
+        // Paged mode: the last element lives in the chunk derived from its index
         _size--;
-        size_type chunk_num = _size / _chunk_capacity;
-        size_type offset    = _size % _chunk_capacity;
-        if (offset == 0 && chunk_num > 0) chunk_num--;
+        size_type chunk_num = Layout::chunk_of(_size);
         Chunk& ch = _chunks[chunk_num];
-        T* ptr = reinterpret_cast<T*>(VMManager::instance().page_write_ptr(ch.page_idx, (ch.count - 1) * sizeof(T)));
-        ptr->~T();
+        if (!std::is_trivially_destructible<T>::value) {
+            T* ptr = reinterpret_cast<T*>(VMManager::instance().page_write_ptr(ch.page_idx, (ch.count - 1) * sizeof(T)));
+            ptr->~T();
+        }
         ch.count--;
-        if (ch.count == 0) {
-            VMManager::instance().page_free(ch.page_idx);
+        // Release the page once the tail chunk is empty (reserved chunks beyond it are kept).
+        if (ch.count == 0 && chunk_num + 1 == _chunk_count) {
+            VMManager::instance().page_discard(ch.page_idx);
             ch.page_idx = -1;
             _chunk_count--;
         }
@@ -1930,7 +5525,7 @@ public:
         size_type idx = pos - begin();
         push_back(T());
         for (size_type i = _size - 1; i > idx; --i)
-            (*this)[i] = (*this)[i - 1];
+            (*this)[i] = cread(i - 1);
         (*this)[idx] = value;
         return iterator(this, idx);
     }
@@ -1944,21 +5539,28 @@ public:
         size_type idx = pos - begin();
         if (idx >= _size) return end();
         for (size_type i = idx; i < _size - 1; ++i)
-            (*this)[i] = (*this)[i + 1];
+            (*this)[i] = cread(i + 1);
         pop_back();
         return iterator(this, idx);
     }
 
     /**
      * @brief Destroy all elements and free pages.
+     *
+     * @details Pages are discarded rather than written back. For trivially destructible T
+     *          no element is touched, so swapped-out chunks are released without any I/O.
+     *          Elements whose page cannot be loaded (e.g. inside a strict VMNoFaultScope) are
+     *          released without running their destructors.
      */
     void clear() {
         if (_flat_mode) {
             // Destroy elements in flat mode
-            if (_flat_page >= 0 && _size > 0) {
-                T* base = reinterpret_cast<T*>(VMManager::instance().small_write_ptr(_flat_page, _flat_offset));
-                for (size_type i = 0; i < _size; ++i) {
-                    base[i].~T();
+            if (_flat_page >= 0) {
+                if (!std::is_trivially_destructible<T>::value && _size > 0) {
+                    T* base = reinterpret_cast<T*>(VMManager::instance().small_write_ptr(_flat_page, _flat_offset));
+                    for (size_type i = 0; base && i < _size; ++i) {
+                        base[i].~T();
+                    }
                 }
                 VMManager::instance().small_free(_flat_page, _flat_offset);
                 _flat_page = -1;
@@ -1970,11 +5572,14 @@ public:
             for (size_type i = 0; i < _chunk_count; ++i) {
                 Chunk& ch = _chunks[i];
                 if (ch.page_idx == -1) continue;
-                for (size_type j = 0; j < ch.count; ++j) {
-                    T* ptr = reinterpret_cast<T*>(VMManager::instance().page_write_ptr(ch.page_idx, j * sizeof(T)));
-                    ptr->~T();
+                if (!std::is_trivially_destructible<T>::value) {
+                    for (size_type j = 0; j < ch.count; ++j) {
+                        T* ptr = reinterpret_cast<T*>(VMManager::instance().page_write_ptr(ch.page_idx, j * sizeof(T)));
+                        if (!ptr) break;
+                        ptr->~T();
+                    }
                 }
-                VMManager::instance().page_free(ch.page_idx);
+                VMManager::instance().page_discard(ch.page_idx);
                 ch.page_idx = -1;
                 ch.count = 0;
             }
@@ -2001,28 +5606,25 @@ public:
      * @param n Desired capacity.
      */
     void reserve(size_type n) {
-        size_type required_chunks = (n + _chunk_capacity - 1) / _chunk_capacity;
-        while (_chunk_count < required_chunks) {
-            int page_idx = -1;
-            VMManager::AllocOptions opts;
-            opts.can_free_ram = true;
-            opts.zero_on_alloc = true;
-            opts.reuse_swap_data = false;
-            VMManager::instance().page_alloc(page_idx, opts);
-            _chunks[_chunk_count].page_idx = page_idx;
-            _chunks[_chunk_count].count = 0;
-            _chunk_count++;
+        if (n <= capacity()) return;
+        if (_flat_mode) {
+            // Grow the flat block if n still fits in one heap block, otherwise go paged.
+            if (n * sizeof(T) <= VMManager::instance().heap_max_payload() && grow_flat(n)) return;
+            transition_to_paged();
         }
+        const size_type required_chunks = Layout::chunk_of(n - 1) + 1;
+        if (required_chunks > Layout::kMaxChunks) throw std::length_error("VMVector::reserve exceeds VM_PAGE_COUNT pages");
+        while (_chunk_count < required_chunks) append_chunk();
     }
 
     /**
      * @brief Release unused trailing pages.
      */
     void shrink_to_fit() {
-        size_type used_chunks = (_size + _chunk_capacity - 1) / _chunk_capacity;
+        size_type used_chunks = _size ? Layout::chunk_of(_size - 1) + 1 : 0;
         for (size_type i = used_chunks; i < _chunk_count; ++i) {
             if (_chunks[i].page_idx != -1) {
-                VMManager::instance().page_free(_chunks[i].page_idx);
+                VMManager::instance().page_discard(_chunks[i].page_idx);
                 _chunks[i].page_idx = -1;
                 _chunks[i].count = 0;
             }
@@ -2035,11 +5637,14 @@ public:
      * @param other Other vector.
      */
     void swap(VMVector& other) {
-        std::swap(_chunk_capacity, other._chunk_capacity);
         std::swap(_size, other._size);
         std::swap(_chunk_count, other._chunk_count);
         for (size_type i = 0; i < VM_PAGE_COUNT; ++i)
             std::swap(_chunks[i], other._chunks[i]);
+        std::swap(_flat_mode, other._flat_mode);
+        std::swap(_flat_page, other._flat_page);
+        std::swap(_flat_offset, other._flat_offset);
+        std::swap(_flat_capacity, other._flat_capacity);
     }
 
     /**
@@ -2104,16 +5709,18 @@ public:
     bool operator>=(const VMVector& other) const { return !(*this < other); }
 
 private:
+    /// Compile-time chunk layout: element idx lives in chunk chunk_of(idx), slot slot_of(idx).
+    using Layout = detail::ChunkLayout<T>;
+
     /**
-     * @brief Internal chunk descriptor (one page).
+     * @brief Internal chunk descriptor (one page, or one extent when T is larger than a page).
      */
     struct Chunk {
-        int page_idx;   ///< Page index in VMManager.
-        size_type count;///< Number of constructed elements in this page.
+        int page_idx;   ///< Page index in VMManager (extent head).
+        size_type count;///< Number of constructed elements in this chunk.
     };
 
-    Chunk _chunks[VM_PAGE_COUNT]; ///< Fixed chunk table (one per possible page).
-    size_type _chunk_capacity;    ///< Elements per chunk.
+    Chunk _chunks[VM_PAGE_COUNT]; ///< Fixed chunk table (at most one per page).
     size_type _chunk_count;       ///< Active chunk count.
     size_type _size;              ///< Total elements.
     
@@ -2123,10 +5730,27 @@ private:
     size_t _flat_offset;          ///< Offset within page for flat block.
     size_type _flat_capacity;     ///< Capacity in elements for flat block.
 
+    friend class VMLockSet;
+    /// Pass the flat block, or every chunk's page (extent head), to f (for VMLockSet).
+    template<typename F>
+    void for_each_page(F&& f) const {
+        if (_flat_mode) {
+            if (_flat_page >= 0) f(_flat_page);
+            return;
+        }
+        for (size_type i = 0; i < _chunk_count; ++i)
+            if (_chunks[i].page_idx >= 0) f(_chunks[i].page_idx);
+    }
+
     /**
      * @brief Ensure space for one more element in flat mode; transition to paged if needed.
      */
     void ensure_flat_back_slot() {
+        // Elements that cannot share a heap block go straight to (multi-page) chunks
+        if (sizeof(T) > VMManager::instance().heap_max_payload()) {
+            transition_to_paged();
+            return;
+        }
         // First-time allocation in flat mode
         if (_flat_page < 0) {
             // Start with a reasonable initial capacity
@@ -2160,57 +5784,97 @@ private:
             return;
         }
         
-        // Try reallocation
+        // Reallocation failed, transition to paged mode
+        if (!grow_flat(new_cap)) transition_to_paged();
+    }
+
+    /**
+     * @brief Move the flat buffer to a block holding at least new_cap elements.
+     * @param new_cap Required capacity in elements (must fit one heap block).
+     * @return True on success (flat state updated), false if allocation failed.
+     */
+    bool grow_flat(size_type new_cap) {
         int new_page = -1;
         size_t new_offset = 0;
         size_t new_alloc = 0;
         size_t needed = new_cap * sizeof(T);
-        size_t copy_bytes = _size * sizeof(T);
-        
-        if (VMManager::instance().small_realloc_move(_flat_page, _flat_offset, needed,
-                                                      new_page, new_offset, new_alloc, copy_bytes)) {
-            _flat_page = new_page;
-            _flat_offset = new_offset;
-            _flat_capacity = new_alloc / sizeof(T);
-            return;
+        if (_flat_page < 0) {
+            if (!VMManager::instance().small_alloc(needed, alignof(T), new_page, new_offset, new_alloc)) return false;
+        } else {
+            size_t copy_bytes = _size * sizeof(T);
+            if (!VMManager::instance().small_realloc_move(_flat_page, _flat_offset, needed,
+                                                           new_page, new_offset, new_alloc, copy_bytes)) return false;
         }
-        
-        // Reallocation failed, transition to paged mode
-        transition_to_paged();
+        _flat_page = new_page;
+        _flat_offset = new_offset;
+        _flat_capacity = new_alloc / sizeof(T);
+        return true;
     }
     
     /**
      * @brief Transition from flat mode to paged mode.
+     * @throws std::runtime_error If the flat buffer or a chunk cannot be loaded.
+     *
+     * @details All chunks are allocated before any element moves. The flat buffer then stays
+     * pinned, and each destination chunk is pinned while its element is constructed, so loading
+     * one never evicts the other. Sources are destroyed only once every element has moved; on
+     * failure the vector stays flat and the new chunks are released.
      */
     void transition_to_paged() {
         if (!_flat_mode) return;
         
-        // Copy existing elements from flat buffer to paged chunks
-        if (_size > 0 && _flat_page >= 0) {
-            T* flat_base = reinterpret_cast<T*>(VMManager::instance().small_read_ptr(_flat_page, _flat_offset));
-            
-            // Allocate chunks as needed and copy elements
+        // Move existing elements from flat buffer to paged chunks
+        if (_flat_page >= 0) {
+            auto& mgr = VMManager::instance();
+            auto drop_chunks = [&]() {
+                while (_chunk_count) {
+                    Chunk& ch = _chunks[--_chunk_count];
+                    mgr.page_discard(ch.page_idx);
+                    ch.page_idx = -1;
+                    ch.count = 0;
+                }
+            };
+            // Allocate every chunk first: if that fails, the flat elements are still untouched.
+            const size_type chunks = _size ? Layout::chunk_of(_size - 1) + 1 : 0;
+            try {
+                while (_chunk_count < chunks) append_chunk();
+            } catch (...) {
+                drop_chunks();
+                throw;
+            }
+            const int src_pin = _size ? mgr.pin_unit(_flat_page) : -1;
+            if (_size && src_pin < 0) {
+                drop_chunks();
+                throw std::runtime_error("VMVector: failed to acquire read pointer");
+            }
             for (size_type i = 0; i < _size; ++i) {
-                if (_chunk_count == 0 || _chunks[_chunk_count - 1].count >= _chunk_capacity) {
-                    int page_idx = -1;
-                    VMManager::AllocOptions opts;
-                    opts.can_free_ram = true;
-                    opts.zero_on_alloc = true;
-                    opts.reuse_swap_data = false;
-                    VMManager::instance().page_alloc(page_idx, opts);
-                    _chunks[_chunk_count].page_idx = page_idx;
-                    _chunks[_chunk_count].count = 0;
-                    _chunk_count++;
+                Chunk& ch = _chunks[Layout::chunk_of(i)];
+                const int dst_pin = mgr.pin_unit(ch.page_idx);
+                T* ptr = dst_pin >= 0 ? reinterpret_cast<T*>(mgr.page_write_ptr(ch.page_idx, ch.count * sizeof(T))) : nullptr;
+                const size_t src_off = _flat_offset + i * sizeof(T);
+                T* src = reinterpret_cast<T*>(std::is_trivially_copyable<T>::value
+                                                  ? mgr.small_read_ptr(_flat_page, src_off)
+                                                  : mgr.small_write_ptr(_flat_page, src_off));
+                if (!ptr || !src) {
+                    // Still flat: the sources are intact (moved-from if T is not trivially copyable).
+                    mgr.unpin_unit(dst_pin);
+                    mgr.unpin_unit(src_pin);
+                    drop_chunks();
+                    throw std::runtime_error("VMVector: failed to acquire write pointer");
                 }
-                
-                Chunk& ch = _chunks[_chunk_count - 1];
-                T* ptr = reinterpret_cast<T*>(VMManager::instance().page_write_ptr(ch.page_idx, ch.count * sizeof(T)));
-                new(ptr) T(flat_base[i]); // Copy construct
+                new(ptr) T(std::move(*src));
                 ch.count++;
+                mgr.unpin_unit(dst_pin);
             }
+            if (!std::is_trivially_destructible<T>::value && _size) {
+                // The pinned flat buffer is resident, so this does not load anything.
+                T* base = reinterpret_cast<T*>(mgr.small_write_ptr(_flat_page, _flat_offset));
+                for (size_type i = 0; base && i < _size; ++i) base[i].~T();
+            }
+            mgr.unpin_unit(src_pin);
             
             // Free the flat buffer
-            VMManager::instance().small_free(_flat_page, _flat_offset);
+            mgr.small_free(_flat_page, _flat_offset);
         }
         
         _flat_mode = false;
@@ -2221,18 +5885,284 @@ private:
 
     /**
      * @brief Ensure space for one more element, allocate new page if needed (paged mode).
+     * @return Chunk that will hold element _size.
+     * @throws std::length_error If all chunks that fit in VM_PAGE_COUNT pages are in use.
      */
-    void ensure_back_slot() {
-        if (_chunk_count == 0 || _chunks[_chunk_count - 1].count >= _chunk_capacity) {
-            int page_idx = -1;
-            VMManager::AllocOptions opts;
-            opts.can_free_ram = true;
-            opts.zero_on_alloc = true;
-            opts.reuse_swap_data = false;
-            VMManager::instance().page_alloc(page_idx, opts);
-            _chunks[_chunk_count].page_idx = page_idx;
-            _chunks[_chunk_count].count = 0;
-            _chunk_count++;
+    Chunk& ensure_back_slot() {
+        const size_type chunk_num = Layout::chunk_of(_size);
+        if (chunk_num >= Layout::kMaxChunks) throw std::length_error("VMVector exceeds VM_PAGE_COUNT pages");
+        while (chunk_num >= _chunk_count) append_chunk();
+        return _chunks[chunk_num];
+    }
+
+    /**
+     * @brief Allocate one zero-filled chunk (page or extent) and append it to the chunk table.
+     * @throws std::runtime_error If no chunk can be allocated.
+     */
+    void append_chunk() {
+        int page_idx = -1;
+        VMManager::AllocOptions opts;
+        opts.can_free_ram = true;
+        opts.zero_on_alloc = true;
+        opts.reuse_swap_data = false;
+        if (!VMManager::instance().extent_alloc(page_idx, Layout::kPagesPerChunk, opts))
+            throw std::runtime_error("VMVector: page_alloc failed");
+        _chunks[_chunk_count].page_idx = page_idx;
+        _chunks[_chunk_count].count = 0;
+        _chunk_count++;
+    }
+};
+
+// -----------------------------------------------------------------------------
+// VMPackedVector
+// -----------------------------------------------------------------------------
+
+/**
+ * @brief Densely packed vector of trivially copyable records stored across whole pages.
+ * @tparam T Element type (must be trivially copyable).
+ *
+ * @details
+ * Elements are laid out back to back in the page sequence with no per-page slack, so records
+ * whose size does not divide VM_PAGE_SIZE (e.g. 12- or 24-byte structs) waste no space at page
+ * ends and a record may straddle two pages. Because a straddling record has no single address
+ * in RAM, elements are accessed by value (get()/set()/read()/write()) rather than by reference,
+ * and there are no iterators. Prefer VMVector when T needs references or non-trivial lifetime.
+ */
+template<typename T>
+class VMPackedVector {
+    static_assert(std::is_trivially_copyable<T>::value, "VMPackedVector requires a trivially copyable type");
+
+public:
+    typedef T value_type;
+    typedef size_t size_type;
+
+    /// Default constructor (no pages allocated).
+    VMPackedVector() : _page_count(0), _size(0) {
+        for (size_type i = 0; i < VM_PAGE_COUNT; ++i) _pages[i] = -1;
+    }
+    /// Fill constructor.
+    VMPackedVector(size_type n, const T& val = T()) : VMPackedVector() { resize(n, val); }
+    VMPackedVector(const VMPackedVector&) = delete;
+    VMPackedVector& operator=(const VMPackedVector&) = delete;
+
+    /// Move constructor.
+    VMPackedVector(VMPackedVector&& other) noexcept
+        : _page_count(other._page_count), _size(other._size) {
+        for (size_type i = 0; i < VM_PAGE_COUNT; ++i) {
+            _pages[i] = other._pages[i];
+            other._pages[i] = -1;
+        }
+        other._page_count = 0;
+        other._size = 0;
+    }
+    /// Move assignment.
+    VMPackedVector& operator=(VMPackedVector&& other) noexcept {
+        if (this != &other) {
+            clear();
+            _page_count = other._page_count;
+            _size = other._size;
+            for (size_type i = 0; i < VM_PAGE_COUNT; ++i) {
+                _pages[i] = other._pages[i];
+                other._pages[i] = -1;
+            }
+            other._page_count = 0;
+            other._size = 0;
+        }
+        return *this;
+    }
+
+    /// Destructor (pages are discarded, not written back).
+    ~VMPackedVector() { clear(); }
+
+    /**
+     * @brief Read element idx (no bounds check; never marks pages dirty).
+     * @param idx Element index.
+     * @return Copy of the element.
+     */
+    T get(size_type idx) const {
+        T val;
+        copy_out(idx * sizeof(T), &val, sizeof(T));
+        return val;
+    }
+
+    /**
+     * @brief Overwrite element idx (no bounds check).
+     * @param idx Element index.
+     * @param val New value.
+     */
+    void set(size_type idx, const T& val) { copy_in(idx * sizeof(T), &val, sizeof(T)); }
+
+    /// Read element idx (no bounds check).
+    T operator[](size_type idx) const { return get(idx); }
+
+    /**
+     * @brief Bounds-checked read.
+     * @param idx Element index.
+     * @return Copy of the element.
+     * @throws std::out_of_range If idx >= size().
+     */
+    T at(size_type idx) const {
+        if (idx >= _size) throw std::out_of_range("VMPackedVector::at");
+        return get(idx);
+    }
+
+    /**
+     * @brief Copy count elements starting at idx into out (one copy per page touched).
+     * @throws std::out_of_range If the range exceeds size().
+     */
+    void read(size_type idx, T* out, size_type count) const {
+        if (idx > _size || count > _size - idx) throw std::out_of_range("VMPackedVector::read");
+        copy_out(idx * sizeof(T), out, count * sizeof(T));
+    }
+
+    /**
+     * @brief Copy count elements from in to positions starting at idx (one copy per page touched).
+     * @throws std::out_of_range If the range exceeds size().
+     */
+    void write(size_type idx, const T* in, size_type count) {
+        if (idx > _size || count > _size - idx) throw std::out_of_range("VMPackedVector::write");
+        copy_in(idx * sizeof(T), in, count * sizeof(T));
+    }
+
+    /// First element (copy).
+    T front() const { return get(0); }
+    /// Last element (copy).
+    T back() const { return get(_size - 1); }
+
+    /**
+     * @brief Append an element.
+     * @param val Value to append.
+     * @throws std::length_error If the VM has no room for another element.
+     */
+    void push_back(const T& val) {
+        ensure_bytes((_size + 1) * sizeof(T));
+        copy_in(_size * sizeof(T), &val, sizeof(T));
+        _size++;
+    }
+
+    /**
+     * @brief Remove last element; a page is released once no element touches it.
+     * @throws std::out_of_range If empty.
+     */
+    void pop_back() {
+        if (_size == 0) throw std::out_of_range("VMPackedVector::pop_back");
+        _size--;
+        const size_type used = pages_for(_size * sizeof(T));
+        if (used + 1 == _page_count) {
+            VMManager::instance().page_discard(_pages[used]);
+            _pages[used] = -1;
+            _page_count = used;
+        }
+    }
+
+    /**
+     * @brief Resize container.
+     * @param n New size.
+     * @param val Fill value for new elements.
+     */
+    void resize(size_type n, const T& val = T()) {
+        if (n <= _size) {
+            _size = n;
+            shrink_to_fit();
+            return;
+        }
+        ensure_bytes(n * sizeof(T));
+        while (_size < n) {
+            copy_in(_size * sizeof(T), &val, sizeof(T));
+            _size++;
+        }
+    }
+
+    /**
+     * @brief Reserve pages for at least n elements.
+     * @throws std::length_error If n elements do not fit in VM_PAGE_COUNT pages.
+     */
+    void reserve(size_type n) { ensure_bytes(n * sizeof(T)); }
+
+    /// Release pages beyond those touched by the current elements.
+    void shrink_to_fit() {
+        const size_type used = pages_for(_size * sizeof(T));
+        while (_page_count > used) {
+            --_page_count;
+            VMManager::instance().page_discard(_pages[_page_count]);
+            _pages[_page_count] = -1;
+        }
+    }
+
+    /// Remove all elements and discard their pages (no write-back).
+    void clear() {
+        _size = 0;
+        shrink_to_fit();
+    }
+
+    /// Number of elements.
+    size_type size() const { return _size; }
+    /// Check if empty.
+    bool empty() const { return _size == 0; }
+    /// Elements that fit in the currently allocated pages.
+    size_type capacity() const { return _page_count * VM_PAGE_SIZE / sizeof(T); }
+    /// Maximum number of elements.
+    size_type max_size() const { return (size_type)VM_PAGE_COUNT * VM_PAGE_SIZE / sizeof(T); }
+
+private:
+    int _pages[VM_PAGE_COUNT]; ///< Owned pages in element order.
+    size_type _page_count;     ///< Allocated page count.
+    size_type _size;           ///< Total elements.
+
+    friend class VMLockSet;
+    /// Pass every owned page to f (for VMLockSet).
+    template<typename F>
+    void for_each_page(F&& f) const {
+        for (size_type i = 0; i < _page_count; ++i) f(_pages[i]);
+    }
+
+    /// Pages needed to hold bytes.
+    static size_type pages_for(size_t bytes) { return (bytes + VM_PAGE_SIZE - 1) / VM_PAGE_SIZE; }
+
+    /**
+     * @brief Allocate zero-filled pages until bytes fit.
+     * @throws std::length_error If more than VM_PAGE_COUNT pages would be needed.
+     * @throws std::runtime_error If no page can be allocated.
+     */
+    void ensure_bytes(size_t bytes) {
+        const size_type need = pages_for(bytes);
+        if (need > VM_PAGE_COUNT) throw std::length_error("VMPackedVector exceeds VM_PAGE_COUNT pages");
+        VMManager::AllocOptions opts;
+        opts.can_free_ram = true;
+        opts.zero_on_alloc = true;
+        opts.reuse_swap_data = false;
+        while (_page_count < need) {
+            if (!VMManager::instance().page_alloc(_pages[_page_count], opts))
+                throw std::runtime_error("VMPackedVector: page_alloc failed");
+            _page_count++;
+        }
+    }
+
+    /// Copy bytes out of the page sequence starting at byte offset off.
+    void copy_out(size_t off, void* dst, size_t bytes) const {
+        auto& mgr = VMManager::instance();
+        uint8_t* out = static_cast<uint8_t*>(dst);
+        while (bytes) {
+            const size_t in_page = off % VM_PAGE_SIZE;
+            const size_t n = std::min(bytes, (size_t)VM_PAGE_SIZE - in_page);
+            const void* src = mgr.page_read_ptr(_pages[off / VM_PAGE_SIZE], in_page);
+            if (!src) throw std::runtime_error("VMPackedVector: failed to get read pointer");
+            memcpy(out, src, n);
+            out += n; off += n; bytes -= n;
+        }
+    }
+
+    /// Copy bytes into the page sequence starting at byte offset off (marks pages dirty).
+    void copy_in(size_t off, const void* src, size_t bytes) {
+        auto& mgr = VMManager::instance();
+        const uint8_t* in = static_cast<const uint8_t*>(src);
+        while (bytes) {
+            const size_t in_page = off % VM_PAGE_SIZE;
+            const size_t n = std::min(bytes, (size_t)VM_PAGE_SIZE - in_page);
+            void* dst = mgr.page_write_ptr(_pages[off / VM_PAGE_SIZE], in_page);
+            if (!dst) throw std::runtime_error("VMPackedVector: failed to get write pointer");
+            memcpy(dst, in, n);
+            in += n; off += n; bytes -= n;
         }
     }
 };
@@ -2242,11 +6172,17 @@ private:
 // -----------------------------------------------------------------------------
 
 /**
- * @brief Fixed-size array backed by a small-heap block.
+ * @brief Fixed-size array backed by a small-heap block or by dedicated pages.
  * @tparam T Element type.
  * @tparam N Number of elements.
  * @details 
- * Now uses VMManager small-block heap so multiple arrays can share pages efficiently.
+ * Storage is chosen at compile time:
+ *  - If N * sizeof(T) fits in one small-heap block, the array lives in the shared heap so multiple
+ *    arrays can share pages efficiently.
+ *  - Otherwise the array owns ceil(N / elements-per-chunk) whole chunks (a chunk is one page, or an
+ *    extent of several pages when T is larger than a page). Elements never straddle a chunk;
+ *    index -> (chunk, offset) is computed by detail::ChunkLayout (shift/mask when the per-chunk count
+ *    is a power of two), so large lookup tables get O(1) indexing without runtime division.
  * 
  * Object lifetime management:
  *  - For trivial types (int, POD structs, etc.): memory is zero-initialized, no constructors/destructors called
@@ -2258,6 +6194,13 @@ private:
  */
 template<typename T, size_t N>
 class VMArray {
+    using Layout = detail::ChunkLayout<T>;
+
+    static constexpr bool   kPaged     = N * sizeof(T) > VMManager::HEAP_MAX_PAYLOAD; ///< True if backed by whole pages.
+    static constexpr size_t kPageCount = kPaged ? (N + Layout::kPerChunk - 1) / Layout::kPerChunk : 1; ///< Chunks owned (1 = heap block).
+
+    static_assert(!kPaged || kPageCount <= Layout::kMaxChunks, "VMArray: array needs more pages than VM_PAGE_COUNT");
+
 public:
     typedef T value_type;
     typedef T& reference;
@@ -2269,79 +6212,103 @@ public:
     using const_iterator         = detail::GenericRandomAccessIterator<VMArray, T, true>;
     using reverse_iterator       = detail::GenericReverseIterator<iterator>;
     using const_reverse_iterator = detail::GenericReverseIterator<const_iterator>;
+    using element_ref            = detail::ElementRef<VMArray, T>; ///< Write-tracking proxy.
 
-    /// Constructor allocates from small-heap blocks.
-    VMArray() : page_idx(-1), offset(0) {
-        size_t needed = N * sizeof(T);
-        size_t alloc_sz = 0;
-        if (!VMManager::instance().small_alloc(needed, alignof(T), page_idx, offset, alloc_sz)) {
-            throw std::runtime_error("VMArray: small_alloc failed");
-        }
-        
-        void* ptr = VMManager::instance().small_write_ptr(page_idx, offset);
-        if (!ptr) {
-            VMManager::instance().small_free(page_idx, offset);
-            throw std::runtime_error("VMArray: failed to acquire write pointer");
-        }
-        
-        // For trivial types, just zero-initialize the memory
-        if (std::is_trivially_default_constructible<T>::value) {
-            memset(ptr, 0, alloc_sz);
-        } else {
-            // For non-trivial types, use placement new to construct each element
-            T* arr = reinterpret_cast<T*>(ptr);
+    /// Constructor allocates a small-heap block, or whole pages for large arrays.
+    VMArray() : offset(0) {
+        for (size_t p = 0; p < kPageCount; ++p) pages[p] = -1;
+        allocate_storage();
+
+        // Trivial types are zero-initialized; non-trivial types are constructed in place.
+        if (!std::is_trivially_default_constructible<T>::value) {
             size_t constructed = 0;
             try {
                 for (size_t i = 0; i < N; ++i) {
-                    new(&arr[i]) T();
+                    new(elem_ptr(i, true)) T();
                     constructed++;
                 }
             } catch (...) {
                 // If construction fails, destroy already constructed elements
                 for (size_t i = 0; i < constructed; ++i) {
-                    arr[i].~T();
+                    reinterpret_cast<T*>(elem_ptr(i, true))->~T();
                 }
-                VMManager::instance().small_free(page_idx, offset);
+                release_storage();
                 throw;
             }
         }
     }
-    /// Destructor frees heap block.
+    /// Destructor destroys elements (non-trivial T) and releases storage.
     ~VMArray() {
-        if (page_idx >= 0) {
+        if (pages[0] >= 0) {
             // For non-trivial types, explicitly call destructors
             if (!std::is_trivially_destructible<T>::value) {
-                void* ptr = VMManager::instance().small_write_ptr(page_idx, offset);
-                if (ptr) {
-                    T* arr = reinterpret_cast<T*>(ptr);
-                    for (size_t i = 0; i < N; ++i) {
-                        arr[i].~T();
-                    }
+                for (size_t i = 0; i < N; ++i) {
+                    void* ptr = elem_ptr(i, true);
+                    if (ptr) reinterpret_cast<T*>(ptr)->~T();
                 }
             }
-            VMManager::instance().small_free(page_idx, offset);
-            page_idx = -1;
+            release_storage();
         }
     }
 
     /**
      * @brief Unchecked element access (write intent).
-     * @param idx Index.
+     * @param idx Index (not bounds-checked).
      * @return Reference.
+     * @throws std::runtime_error If the element's page cannot be loaded (e.g. refused in a
+     *         strict VMNoFaultScope).
      */
     reference operator[](size_type idx) {
-        return *reinterpret_cast<T*>(
-            static_cast<uint8_t*>(VMManager::instance().small_write_ptr(page_idx, offset)) + idx * sizeof(T));
+        void* p = elem_ptr(idx, true);
+        if (!p) throw std::runtime_error("VMArray: failed to acquire write pointer");
+        return *reinterpret_cast<T*>(p);
     }
     /**
      * @brief Unchecked element access (read intent).
-     * @param idx Index.
+     * @param idx Index (not bounds-checked).
      * @return Const reference.
+     * @throws std::runtime_error If the element's page cannot be loaded.
      */
     const_reference operator[](size_type idx) const {
-        return *reinterpret_cast<const T*>(
-            static_cast<const uint8_t*>(VMManager::instance().small_read_ptr(page_idx, offset)) + idx * sizeof(T));
+        const void* p = elem_ptr(idx, false);
+        if (!p) throw std::runtime_error("VMArray: failed to acquire read pointer");
+        return *reinterpret_cast<const T*>(p);
+    }
+    /**
+     * @brief Unchecked read-only access, usable on non-const arrays (does not mark dirty).
+     * @param idx Index.
+     * @return Const reference.
+     */
+    const_reference cread(size_type idx) const { return (*this)[idx]; }
+
+    /**
+     * @brief Write-tracking element access: reads do not mark dirty, assignment does.
+     * @param idx Index.
+     * @return Proxy reference.
+     */
+    element_ref ref(size_type idx) { return element_ref(this, idx); }
+
+    /**
+     * @brief Read-only view of the elements starting at idx (does not mark dirty).
+     * @param idx First element index.
+     * @param count Output number of elements readable through the returned pointer.
+     * @return Pointer to element idx, or nullptr (count = 0) if idx >= N.
+     *
+     * @details For page-backed arrays the run ends at the end of the page holding idx.
+     */
+    const T* read_span(size_type idx, size_type& count) const {
+        count = 0;
+        if (idx >= N) return nullptr;
+        const T* ptr = reinterpret_cast<const T*>(elem_ptr(idx, false));
+        if (!ptr) return nullptr;
+        if (kPaged) {
+            count = std::min<size_type>(N - idx, Layout::kPerChunk - Layout::slot_of(idx));
+        } else {
+            count = N - idx;
+        }
+        return ptr;
     }
+
     /**
      * @brief Bounds-checked access.
      * @param idx Index.
@@ -2375,12 +6342,13 @@ public:
     }
 
     /**
-     * @brief Reset array elements to default constructed T() and flush page.
+     * @brief Reset array elements to default constructed T() and flush the backing page(s).
      */
     void clear() {
         for (size_type i = 0; i < N; ++i)
             (*this)[i] = T();
-        VMManager::instance().page_flush(page_idx);
+        for (size_t p = 0; p < kPageCount; ++p)
+            VMManager::instance().page_flush(pages[p]);
     }
 
     // Iterators
@@ -2399,8 +6367,83 @@ public:
     const_reverse_iterator crend()   const { return const_reverse_iterator(begin()); }
 
 private:
-    int page_idx;      ///< Page index in heap page.
-    size_t offset;     ///< Offset within the page.
+    int pages[kPageCount]; ///< Heap page (small mode) or owned pages (paged mode).
+    size_t offset;         ///< Payload offset within the heap page (small mode only).
+
+    friend class VMLockSet;
+    /// Pass the heap block's page or every owned extent head to f (for VMLockSet).
+    template<typename F>
+    void for_each_page(F&& f) const {
+        for (size_t p = 0; p < kPageCount; ++p)
+            if (pages[p] >= 0) f(pages[p]);
+    }
+
+    /**
+     * @brief Acquire pointer to element idx.
+     * @param idx Element index.
+     * @param write True for write intent (marks page dirty).
+     * @return Pointer or nullptr.
+     */
+    void* elem_ptr(size_type idx, bool write) const {
+        auto& mgr = VMManager::instance();
+        if constexpr (kPaged) {
+            const int pg = pages[Layout::chunk_of(idx)];
+            const size_t off = Layout::slot_of(idx) * sizeof(T);
+            return write ? mgr.page_write_ptr(pg, off) : mgr.page_read_ptr(pg, off);
+        } else {
+            const size_t off = offset + idx * sizeof(T);
+            return write ? mgr.small_write_ptr(pages[0], off) : mgr.small_read_ptr(pages[0], off);
+        }
+    }
+
+    /**
+     * @brief Allocate backing storage (zero-filled).
+     * @throws std::runtime_error If allocation fails.
+     */
+    void allocate_storage() {
+        auto& mgr = VMManager::instance();
+        if constexpr (kPaged) {
+            VMManager::AllocOptions opts;
+            opts.can_free_ram = true;
+            opts.zero_on_alloc = true;
+            opts.reuse_swap_data = false;
+            for (size_t p = 0; p < kPageCount; ++p) {
+                if (!mgr.extent_alloc(pages[p], Layout::kPagesPerChunk, opts)) {
+                    release_storage();
+                    throw std::runtime_error("VMArray: page_alloc failed");
+                }
+            }
+        } else {
+            size_t alloc_sz = 0;
+            if (!mgr.small_alloc(N * sizeof(T), alignof(T), pages[0], offset, alloc_sz)) {
+                pages[0] = -1;
+                throw std::runtime_error("VMArray: small_alloc failed");
+            }
+            void* ptr = mgr.small_write_ptr(pages[0], offset);
+            if (!ptr) {
+                release_storage();
+                throw std::runtime_error("VMArray: failed to acquire write pointer");
+            }
+            memset(ptr, 0, alloc_sz);
+        }
+    }
+
+    /**
+     * @brief Release backing storage without writing it back.
+     */
+    void release_storage() {
+        auto& mgr = VMManager::instance();
+        if constexpr (kPaged) {
+            for (size_t p = 0; p < kPageCount; ++p) {
+                if (pages[p] >= 0) mgr.page_discard(pages[p]);
+                pages[p] = -1;
+            }
+        } else {
+            if (pages[0] >= 0) mgr.small_free(pages[0], offset);
+            pages[0] = -1;
+            offset = 0;
+        }
+    }
 };
 
 // -----------------------------------------------------------------------------
@@ -2425,6 +6468,7 @@ public:
     using const_iterator         = detail::GenericRandomAccessIterator<VMString, char, true>;
     using reverse_iterator       = detail::GenericReverseIterator<iterator>;
     using const_reverse_iterator = detail::GenericReverseIterator<const_iterator>;
+    using element_ref            = detail::ElementRef<VMString, char>; ///< Write-tracking proxy.
 
     static constexpr size_type npos = static_cast<size_type>(-1); ///< Not-found value.
 
@@ -2544,6 +6588,33 @@ public:
         if (idx >= _size) throw std::out_of_range("VMString::operator[] const");
         return read_buf()[idx];
     }
+    /**
+     * @brief Bounds-checked read-only access, usable on non-const strings (does not mark dirty).
+     * @param idx Index.
+     * @throws std::out_of_range If idx >= size().
+     */
+    const_reference cread(size_type idx) const {
+        if (idx >= _size) throw std::out_of_range("VMString::cread");
+        return read_buf()[idx];
+    }
+    /**
+     * @brief Write-tracking character access: reads do not mark dirty, assignment does.
+     * @param idx Index.
+     * @return Proxy reference.
+     */
+    element_ref ref(size_type idx) { return element_ref(this, idx); }
+    /**
+     * @brief Read-only view of the characters starting at pos (does not mark dirty).
+     * @param pos First character index.
+     * @param count Output number of characters readable through the returned pointer.
+     * @return Pointer to character pos, or nullptr (count = 0) if pos >= size().
+     */
+    const char* read_span(size_type pos, size_type& count) const {
+        count = 0;
+        if (pos >= _size) return nullptr;
+        count = _size - pos;
+        return read_buf() + pos;
+    }
     /// Get first character.
     reference front() {
         if (empty()) throw std::out_of_range("VMString::front");
@@ -2973,6 +7044,13 @@ private:
     size_type _size;            ///< Current string length.
     size_type _capacity;        ///< Usable character capacity (excl. null).
 
+    friend class VMLockSet;
+    /// Pass the string block's page index to f (for VMLockSet).
+    template<typename F>
+    void for_each_page(F&& f) const {
+        if (_page_idx >= 0) f(_page_idx);
+    }
+
     /**
      * @brief Allocate initial heap block and setup internal state.
      * @param min_capacity Required capacity hint (within a single heap block).
@@ -3003,13 +7081,27 @@ private:
         size_t new_off = 0;
         size_t new_alloc = 0;
         size_t need = min_capacity; // includes null already when called
-        if (!VMManager::instance().small_alloc(need, alignof(char), new_page_idx, new_off, new_alloc))
+        auto& mgr = VMManager::instance();
+        if (!mgr.small_alloc(need, alignof(char), new_page_idx, new_off, new_alloc))
             throw std::length_error("VMString::reserve: cannot allocate requested capacity");
-        char* new_buf = reinterpret_cast<char*>(VMManager::instance().small_write_ptr(new_page_idx, new_off));
         size_type copy_len = std::min(_size, new_alloc > 0 ? (new_alloc - 1) : 0);
+        // Pin the old block so loading the new one cannot evict it before the copy.
+        const int pinned = copy_len ? mgr.pin_unit(_page_idx) : -1;
+        char* new_buf = (copy_len && pinned < 0) ? nullptr
+                      : reinterpret_cast<char*>(mgr.small_write_ptr(new_page_idx, new_off));
+        if (!new_buf) {
+            if (pinned >= 0) mgr.unpin_unit(pinned);
+            mgr.small_free(new_page_idx, new_off);
+            throw std::runtime_error("VMString: failed to acquire write buffer");
+        }
         if (copy_len) {
-            const char* src = read_buf();
-            memcpy(new_buf, src, copy_len);
+            const char* src = reinterpret_cast<const char*>(mgr.small_read_ptr(_page_idx, _offset));
+            if (src) memcpy(new_buf, src, copy_len);
+            mgr.unpin_unit(pinned);
+            if (!src) {
+                mgr.small_free(new_page_idx, new_off);
+                throw std::runtime_error("VMString: failed to acquire read buffer");
+            }
         }
         _size = copy_len;
         new_buf[_size] = '\0';
@@ -0,0 +1,374 @@
+/**
+ * @file vm_bench.cpp
+ * @brief Host-side workload harness: drives MicroSwap containers with scripted scenarios modeled
+ * on typical firmware and reports throughput, faults and swap I/O per scenario.
+ *
+ * Swap lives in a VMSimSwapBackend, so I/O counts and simulated I/O time are identical on every
+ * run with the same options; the resident page cap (--frames) plays the role of device RAM.
+ *
+ * Scenarios:
+ *   sensor    VMVector<Sample>::push_back of timestamped readings with a periodic window scan
+ *   kvcache   config cache of VMString keys and VMPtr records, skewed lookups, some updates
+ *   logparse  log lines in VMString parsed with find()/substr(), counters per level and module
+ *   churn     mixed-size make_vm()/destroy() with random touches of live objects
+ *
+ * Build (any C++17 compiler):
+ *   g++ -std=c++17 -O2 -I. -o vm_bench extras/vm_bench/vm_bench.cpp
+ *
+ * Usage:
+ *   vm_bench [--scenario sensor,kvcache,logparse,churn] [--frames 8,16,32] [--scale 1] [--seed 1]
+ *            [--read-us 300] [--write-us 900] [--read-kbps 4000] [--write-kbps 1500] [--stall-permille 5]
+ *            [--random-write-us 2000]
+ *
+ * Columns: ops is the scenario's operation count (pushes, lookups, lines or allocations plus
+ * touches); cpu_ms is host time, io_ms the simulated storage time and kops/s = ops / (cpu + io).
+ * faults and writebacks are swap reads and writes, KiB_rd / KiB_wr the bytes moved (writes after
+ * sector rounding). Compare rows of one build; cpu_ms depends on the host. Build with
+ * -DVM_SWAP_LOG=1 to measure the log-structured swap against the default fixed slots.
+ */
+
+#if !defined(ARDUINO)
+
+#ifndef VM_PAGE_SIZE
+#define VM_PAGE_SIZE 1024
+#endif
+#ifndef VM_PAGE_COUNT
+#define VM_PAGE_COUNT 256
+#endif
+#include "containers.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+/** @brief Workload size and randomness shared by all scenarios. */
+struct Params {
+    uint32_t scale = 1; ///< Multiplies every scenario's operation count.
+    uint32_t seed = 1;  ///< Seed of the workload generator.
+};
+
+/** @brief One scenario: a name and a function returning its operation count. */
+struct Scenario {
+    const char* name;
+    uint64_t (*run)(const Params&);
+};
+
+// -------------------- sensor --------------------
+
+/** @brief One logged reading (24 bytes, like a timestamped IMU sample). */
+struct Sample {
+    uint32_t ts;
+    float v[4];
+    uint32_t flags;
+};
+
+/// Append readings and, every 64 samples, average the last 512 (a rolling dashboard).
+uint64_t run_sensor(const Params& p) {
+    std::mt19937 rng(p.seed);
+    std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+    const size_t total = 4000u * p.scale;
+    const size_t window = 512;
+    VMVector<Sample> log;
+    uint64_t ops = 0;
+    volatile float sink = 0;
+    for (size_t i = 0; i < total; ++i) {
+        Sample s{(uint32_t)i * 10u, {noise(rng), noise(rng), noise(rng), 9.81f + noise(rng)}, 0};
+        log.push_back(s);
+        ++ops;
+        if (i % 64 == 63) {
+            const size_t n = log.size();
+            const size_t from = n > window ? n - window : 0;
+            float acc = 0;
+            for (size_t k = from; k < n; ++k) acc += log.cread(k).v[3];
+            sink = acc / (float)(n - from);
+            ops += n - from;
+        }
+    }
+    (void)sink;
+    return ops;
+}
+
+// -------------------- kvcache --------------------
+
+/** @brief Cached configuration value. */
+struct Record {
+    int32_t value;
+    uint32_t hits;
+    uint32_t version;
+    char unit[20];
+};
+
+/// 600 keys in a RAM hash index; 80% of lookups hit the hottest 20% of keys, 1 in 10 updates.
+uint64_t run_kvcache(const Params& p) {
+    std::mt19937 rng(p.seed);
+    const size_t keys = 600;
+    const size_t buckets = 128;
+    std::vector<VMString> names;
+    std::vector<VMPtr<Record>> records;
+    std::vector<std::vector<uint16_t>> index(buckets);
+    names.reserve(keys);
+    records.reserve(keys);
+    auto hash = [](const char* s) {
+        uint32_t h = 2166136261u;
+        for (; *s; ++s) h = (h ^ (uint8_t)*s) * 16777619u;
+        return h;
+    };
+    char key[48];
+    for (size_t i = 0; i < keys; ++i) {
+        snprintf(key, sizeof(key), "net.wifi.profile%u.param", (unsigned)i);
+        names.emplace_back(key);
+        records.push_back(make_vm<Record>(Record{(int32_t)i, 0, 0, "ms"}));
+        index[hash(key) % buckets].push_back((uint16_t)i);
+    }
+    const size_t lookups = 20000u * p.scale;
+    std::uniform_int_distribution<uint32_t> pct(0, 99);
+    std::uniform_int_distribution<size_t> hot(0, keys / 5 - 1), any(0, keys - 1);
+    uint64_t found = 0;
+    for (size_t n = 0; n < lookups; ++n) {
+        const size_t want = pct(rng) < 80 ? hot(rng) * 5 : any(rng); // hot keys are spread over the table
+        snprintf(key, sizeof(key), "net.wifi.profile%u.param", (unsigned)want);
+        for (uint16_t i : index[hash(key) % buckets]) {
+            if (names[i].compare(key) != 0) continue;
+            ++found;
+            if (pct(rng) < 10) {
+                Record& r = *records[i];
+                r.value += 1;
+                r.version++;
+            } else {
+                const VMPtr<Record>& r = records[i];
+                found += (uint64_t)(r->value < 0);
+            }
+            break;
+        }
+    }
+    for (auto& r : records) r.destroy();
+    return lookups + (found == 0); // found keeps the loop observable
+}
+
+// -------------------- logparse --------------------
+
+/// Keep the last 256 log lines in VMString and parse each new line's level, module and duration.
+uint64_t run_logparse(const Params& p) {
+    std::mt19937 rng(p.seed);
+    static const char* levels[] = {"INFO", "INFO", "INFO", "DEBUG", "DEBUG", "WARN", "ERROR"};
+    static const char* modules[] = {"wifi", "mqtt", "sensor", "ota", "ui", "storage"};
+    const size_t ring = 256;
+    const size_t lines = 6000u * p.scale;
+    std::vector<VMString> history;
+    history.reserve(ring);
+    uint32_t per_level[4] = {0, 0, 0, 0};
+    uint32_t per_module[6] = {0, 0, 0, 0, 0, 0};
+    uint64_t total_ms = 0;
+    char line[128];
+    for (size_t n = 0; n < lines; ++n) {
+        snprintf(line, sizeof(line), "ts=%lu level=%s mod=%s took=%ums msg=request %lu completed",
+                 (unsigned long)(n * 37), levels[rng() % 7], modules[rng() % 6], (unsigned)(rng() % 500),
+                 (unsigned long)rng());
+        if (history.size() < ring) history.emplace_back(line);
+        else history[n % ring] = VMString(line);
+
+        // Parse the line back out of VM, as a log shipper would.
+        const VMString& s = history[n % ring];
+        const size_t lv = s.find("level=");
+        const size_t md = s.find("mod=");
+        const size_t tk = s.find("took=");
+        if (lv == VMString::npos || md == VMString::npos || tk == VMString::npos) continue;
+        VMString level = s.substr(lv + 6, s.find(' ', lv) - lv - 6);
+        VMString module = s.substr(md + 4, s.find(' ', md) - md - 4);
+        VMString took = s.substr(tk + 5, s.find('m', tk) - tk - 5);
+        per_level[level.compare("INFO") == 0 ? 0 : level.compare("DEBUG") == 0 ? 1 : level.compare("WARN") == 0 ? 2 : 3]++;
+        for (size_t m = 0; m < 6; ++m)
+            if (module.compare(modules[m]) == 0) per_module[m]++;
+        total_ms += strtoul(took.c_str(), nullptr, 10);
+    }
+    // Periodic "grep ERROR" over the retained history.
+    uint64_t errors = 0;
+    for (const VMString& s : history) errors += s.find("level=ERROR") != VMString::npos;
+    return lines + history.size() + ((per_level[3] + per_module[0] + total_ms + errors) == 0);
+}
+
+// -------------------- churn --------------------
+
+struct Small { uint32_t id; uint32_t v[3]; };        ///< 16 bytes (list node)
+struct Medium { uint32_t id; uint8_t payload[44]; }; ///< 48 bytes (message)
+struct Large { uint32_t id; uint8_t payload[196]; }; ///< 200 bytes (frame buffer slice)
+
+/** @brief Live set of one object type with create/destroy/touch helpers. */
+template<class T>
+struct Pool {
+    std::vector<VMPtr<T>> live;
+    void create(uint32_t id, size_t cap) {
+        if (live.size() >= cap) return;
+        T init{};
+        init.id = id;
+        live.push_back(make_vm<T>(init));
+    }
+    void destroy(std::mt19937& rng) {
+        if (live.empty()) return;
+        const size_t i = rng() % live.size();
+        live[i].destroy();
+        live[i] = live.back();
+        live.pop_back();
+    }
+    void touch(std::mt19937& rng) {
+        if (live.empty()) return;
+        live[rng() % live.size()]->id++;
+    }
+    void clear() {
+        for (auto& p : live) p.destroy();
+        live.clear();
+    }
+};
+
+/// Random mix: 40% create, 30% destroy, 30% touch, spread over three object sizes.
+uint64_t run_churn(const Params& p) {
+    std::mt19937 rng(p.seed);
+    Pool<Small> small;
+    Pool<Medium> medium;
+    Pool<Large> large;
+    const size_t steps = 30000u * p.scale;
+    for (size_t n = 0; n < steps; ++n) {
+        const uint32_t op = rng() % 10, kind = rng() % 3;
+        if (op < 4) {
+            if (kind == 0) small.create((uint32_t)n, 1500);
+            else if (kind == 1) medium.create((uint32_t)n, 600);
+            else large.create((uint32_t)n, 150);
+        } else if (op < 7) {
+            if (kind == 0) small.destroy(rng);
+            else if (kind == 1) medium.destroy(rng);
+            else large.destroy(rng);
+        } else {
+            if (kind == 0) small.touch(rng);
+            else if (kind == 1) medium.touch(rng);
+            else large.touch(rng);
+        }
+    }
+    small.clear();
+    medium.clear();
+    large.clear();
+    return steps;
+}
+
+const Scenario kScenarios[] = {
+    {"sensor", run_sensor},
+    {"kvcache", run_kvcache},
+    {"logparse", run_logparse},
+    {"churn", run_churn},
+};
+
+/** @brief Parse a comma-separated list of unsigned numbers. */
+std::vector<uint32_t> parse_list(const char* s) {
+    std::vector<uint32_t> v;
+    while (*s) {
+        char* end = nullptr;
+        v.push_back((uint32_t)strtoul(s, &end, 10));
+        if (end == s) break;
+        s = *end == ',' ? end + 1 : end;
+    }
+    return v;
+}
+
+/** @brief Split a comma-separated list of words. */
+std::vector<std::string> parse_words(const char* s) {
+    std::vector<std::string> v;
+    std::string cur;
+    for (; *s; ++s) {
+        if (*s == ',') { v.push_back(cur); cur.clear(); }
+        else cur += *s;
+    }
+    if (!cur.empty()) v.push_back(cur);
+    return v;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Params params;
+    VMSimCostModel model;
+    model.advance_clock = false;
+    std::vector<uint32_t> frames{16, 32, 64};
+    std::vector<std::string> names;
+    if (argc % 2 == 0) {
+        fprintf(stderr, "vm_bench: option %s needs a value\n", argv[argc - 1]);
+        return 2;
+    }
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const std::string opt = argv[i];
+        const char* val = argv[i + 1];
+        if (opt == "--scenario") names = parse_words(val);
+        else if (opt == "--frames") frames = parse_list(val);
+        else if (opt == "--scale") params.scale = (uint32_t)strtoul(val, nullptr, 10);
+        else if (opt == "--seed") params.seed = model.seed = (uint32_t)strtoul(val, nullptr, 10);
+        else if (opt == "--read-us") model.read_latency_us = (uint32_t)strtoul(val, nullptr, 10);
+        else if (opt == "--write-us") model.write_latency_us = (uint32_t)strtoul(val, nullptr, 10);
+        else if (opt == "--read-kbps") model.read_kb_per_s = (uint32_t)strtoul(val, nullptr, 10);
+        else if (opt == "--write-kbps") model.write_kb_per_s = (uint32_t)strtoul(val, nullptr, 10);
+        else if (opt == "--stall-permille") model.gc_stall_permille = (uint32_t)strtoul(val, nullptr, 10);
+        else if (opt == "--random-write-us") model.random_write_us = (uint32_t)strtoul(val, nullptr, 10);
+        else {
+            fprintf(stderr, "usage: %s [--scenario a,b] [--frames N,..] [--scale K] [--seed S]\n"
+                            "       [--read-us U] [--write-us U] [--read-kbps K] [--write-kbps K] [--stall-permille P]\n"
+                            "       [--random-write-us U]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (params.scale == 0) params.scale = 1;
+    if (names.empty())
+        for (const Scenario& s : kScenarios) names.push_back(s.name);
+    for (const std::string& n : names) {
+        bool known = false;
+        for (const Scenario& s : kScenarios) known = known || n == s.name;
+        if (!known) {
+            fprintf(stderr, "vm_bench: unknown scenario %s\n", n.c_str());
+            return 2;
+        }
+    }
+
+    auto& vm = VMManager::instance();
+    printf("page size %u, %u pages, scale %u, seed %u\n", (unsigned)VM_PAGE_SIZE, (unsigned)VM_PAGE_COUNT,
+           (unsigned)params.scale, (unsigned)params.seed);
+    printf("%-9s %6s %9s %8s %9s %9s %8s %10s %9s %9s\n", "scenario", "frames", "ops", "cpu_ms", "io_ms",
+           "kops/s", "faults", "writebacks", "KiB_rd", "KiB_wr");
+    for (const std::string& n : names) {
+        const Scenario* sc = nullptr;
+        for (const Scenario& s : kScenarios)
+            if (n == s.name) sc = &s;
+        for (uint32_t f : frames) {
+            if (f == 0) continue;
+            VMSimSwapBackend sim(model);
+            vm.set_frame_limit(f);
+            if (!vm.begin(sim)) {
+                fprintf(stderr, "vm_bench: begin() failed\n");
+                return 1;
+            }
+            const auto t0 = std::chrono::steady_clock::now();
+            uint64_t ops = 0;
+            bool failed = false;
+            try {
+                ops = sc->run(params);
+            } catch (const std::exception& e) {
+                fprintf(stderr, "vm_bench: %s with %u frames: %s\n", sc->name, (unsigned)f, e.what());
+                failed = true;
+            }
+            const double cpu_ms =
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            const double io_ms = sim.elapsed_us() / 1000.0;
+            const uint32_t faults = sim.reads(), writebacks = sim.writes();
+            const uint64_t rd = sim.bytes_read(), wr = sim.bytes_written();
+            vm.end();
+            if (failed) continue;
+            printf("%-9s %6u %9llu %8.1f %9.1f %9.1f %8u %10u %9llu %9llu\n", sc->name, (unsigned)f,
+                   (unsigned long long)ops, cpu_ms, io_ms, ops / (cpu_ms + io_ms), faults, writebacks,
+                   (unsigned long long)(rd / 1024), (unsigned long long)(wr / 1024));
+        }
+    }
+    return 0;
+}
+
+#endif // !ARDUINO
@@ -0,0 +1,310 @@
+/**
+ * @file vm_replay.cpp
+ * @brief Host-side replay of a MicroSwap access log against alternative paging configurations.
+ *
+ * Record a log on the device with VM_ACCESS_LOG > 0 and VMManager::access_log_begin(), copy the
+ * file to a PC and replay it here to compare frame counts, page sizes, eviction policies and
+ * swap I/O latency models without re-flashing.
+ *
+ * Build (any C++17 compiler):
+ *   g++ -std=c++17 -O2 -o vm_replay extras/vm_replay/vm_replay.cpp
+ *
+ * Usage:
+ *   vm_replay trace.bin [--frames 4,8,12,16] [--page-size 1024,4096] [--policy lru,fifo,clock,random,opt]
+ *             [--read-us 800] [--read-us-per-kb 40] [--write-us 1500] [--write-us-per-kb 60] [--seed 1]
+ *
+ * Semantics match VMManager: a page that was never written back is regenerated as zeros without
+ * I/O (a first touch is not a fault), a miss on a written-back page reads it, evicting a page
+ * written since it was loaded writes it back, and freed pages leave RAM without a write-back.
+ * With a page size other than the recorded one, addresses are regrouped into the new page size
+ * and free records are ignored (a new page may hold data of several recorded pages).
+ */
+
+#if !defined(ARDUINO)
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t kMagic   = 0x54414D56u; // 'VMAT'
+constexpr uint32_t kVersion = 1;
+
+/** @brief One replayed record. */
+struct Access {
+    uint32_t addr; ///< Byte address (recorded page * page size + offset).
+    uint8_t kind;  ///< 0 read, 1 write, 2 page freed.
+};
+
+/** @brief Recorded log: header values and records. */
+struct Log {
+    uint32_t page_size = 0;
+    uint32_t page_count = 0;
+    std::vector<Access> records;
+};
+
+/** @brief I/O latency model: fixed cost per operation plus a per-KiB transfer cost. */
+struct LatencyModel {
+    double read_us = 800, read_us_per_kb = 40;
+    double write_us = 1500, write_us_per_kb = 60;
+};
+
+/** @brief Result of one simulated configuration. */
+struct Result {
+    uint64_t accesses = 0;
+    uint64_t first_touches = 0;
+    uint64_t faults = 0;
+    uint64_t writebacks = 0;
+    double io_ms = 0;
+};
+
+/**
+ * @brief Load an access log written by VMManager::access_log_begin().
+ * @param path File path.
+ * @param out Output log.
+ * @return False (with a message on stderr) if the file is missing or not an access log.
+ */
+bool load_log(const char* path, Log& out) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "vm_replay: cannot open %s\n", path);
+        return false;
+    }
+    uint32_t header[4];
+    if (fread(header, sizeof(header), 1, f) != 1 || header[0] != kMagic || header[1] != kVersion) {
+        fprintf(stderr, "vm_replay: %s is not a version %u access log\n", path, (unsigned)kVersion);
+        fclose(f);
+        return false;
+    }
+    out.page_size = header[2];
+    out.page_count = header[3];
+    uint32_t rec[1024];
+    size_t n;
+    while ((n = fread(rec, sizeof(uint32_t), 1024, f)) > 0) {
+        for (size_t i = 0; i < n; ++i) out.records.push_back(Access{rec[i] & 0x3FFFFFFFu, (uint8_t)(rec[i] >> 30)});
+    }
+    fclose(f);
+    return true;
+}
+
+/**
+ * @brief Replay the log with one configuration.
+ * @param log Recorded log.
+ * @param page_size Simulated page size.
+ * @param frames Pages that fit in RAM.
+ * @param policy "lru", "fifo", "clock", "random" or "opt" (Belady, an unreachable lower bound).
+ * @param lat I/O latency model.
+ * @param seed Seed for the random policy.
+ * @return Counters.
+ */
+Result simulate(const Log& log, uint32_t page_size, size_t frames, const std::string& policy,
+                const LatencyModel& lat, uint32_t seed) {
+    struct Frame {
+        uint32_t page;
+        bool dirty;
+        bool ref;         // clock reference bit
+        uint64_t stamp;   // lru: last use, fifo: load time
+    };
+    const bool keep_frees = page_size == log.page_size;
+    const size_t n = log.records.size();
+
+    // Belady needs the next use of every record's page.
+    std::vector<size_t> next_use;
+    if (policy == "opt") {
+        next_use.assign(n, std::numeric_limits<size_t>::max());
+        std::unordered_map<uint32_t, size_t> later;
+        for (size_t i = n; i-- > 0;) {
+            const Access& a = log.records[i];
+            const uint32_t p = a.addr / page_size;
+            if (a.kind == 2) {
+                if (keep_frees) later.erase(p);
+                continue;
+            }
+            auto it = later.find(p);
+            if (it != later.end()) next_use[i] = it->second;
+            later[p] = i;
+        }
+    }
+
+    Result r;
+    std::vector<Frame> ram;
+    std::unordered_map<uint32_t, size_t> where;         // page -> frame slot
+    std::unordered_map<uint32_t, size_t> upcoming;      // opt: page -> next use index
+    std::unordered_map<uint32_t, bool> swapped;         // page has content in swap (else zero, no I/O)
+    std::mt19937 rng(seed);
+    size_t hand = 0;
+    const double kb = page_size / 1024.0;
+
+    for (size_t i = 0; i < n; ++i) {
+        const Access& a = log.records[i];
+        const uint32_t p = a.addr / page_size;
+        if (a.kind == 2) {
+            if (!keep_frees) continue;
+            auto it = where.find(p);
+            if (it != where.end()) {
+                const size_t slot = it->second;
+                where.erase(it);
+                if (slot != ram.size() - 1) {
+                    ram[slot] = ram.back();
+                    where[ram[slot].page] = slot;
+                }
+                ram.pop_back();
+                if (hand >= ram.size()) hand = 0;
+            }
+            swapped.erase(p);
+            upcoming.erase(p);
+            continue;
+        }
+        ++r.accesses;
+        if (!next_use.empty()) upcoming[p] = next_use[i];
+
+        auto it = where.find(p);
+        if (it != where.end()) {
+            Frame& fr = ram[it->second];
+            fr.dirty = fr.dirty || a.kind == 1;
+            fr.ref = true;
+            if (policy != "fifo") fr.stamp = i;
+            continue;
+        }
+
+        // Miss: a page never written back is regenerated as zeros, otherwise it is read from swap.
+        if (swapped.count(p)) {
+            ++r.faults;
+            r.io_ms += (lat.read_us + lat.read_us_per_kb * kb) / 1000.0;
+        } else {
+            ++r.first_touches;
+        }
+        if (ram.size() >= frames) {
+            size_t victim = 0;
+            if (policy == "random") {
+                victim = std::uniform_int_distribution<size_t>(0, ram.size() - 1)(rng);
+            } else if (policy == "clock") {
+                while (ram[hand].ref) {
+                    ram[hand].ref = false;
+                    hand = (hand + 1) % ram.size();
+                }
+                victim = hand;
+                hand = (hand + 1) % ram.size();
+            } else if (policy == "opt") {
+                size_t best = 0;
+                for (size_t s = 0; s < ram.size(); ++s) {
+                    auto u = upcoming.find(ram[s].page);
+                    const size_t next = u == upcoming.end() ? std::numeric_limits<size_t>::max() : u->second;
+                    if (next >= best) { best = next; victim = s; }
+                }
+            } else { // lru and fifo both evict the smallest stamp
+                for (size_t s = 1; s < ram.size(); ++s)
+                    if (ram[s].stamp < ram[victim].stamp) victim = s;
+            }
+            Frame& v = ram[victim];
+            if (v.dirty) {
+                ++r.writebacks;
+                r.io_ms += (lat.write_us + lat.write_us_per_kb * kb) / 1000.0;
+                swapped[v.page] = true; // from now on a miss reads it back
+            }
+            where.erase(v.page);
+            v = Frame{p, a.kind == 1, true, i};
+            where[p] = victim;
+        } else {
+            where[p] = ram.size();
+            ram.push_back(Frame{p, a.kind == 1, true, i});
+        }
+    }
+    return r;
+}
+
+/** @brief Parse a comma-separated list of unsigned numbers. */
+std::vector<uint32_t> parse_list(const char* s) {
+    std::vector<uint32_t> v;
+    while (*s) {
+        char* end = nullptr;
+        v.push_back((uint32_t)strtoul(s, &end, 10));
+        s = *end == ',' ? end + 1 : end;
+        if (end == s && *s) break;
+    }
+    return v;
+}
+
+/** @brief Split a comma-separated list of words. */
+std::vector<std::string> parse_words(const char* s) {
+    std::vector<std::string> v;
+    std::string cur;
+    for (; *s; ++s) {
+        if (*s == ',') { v.push_back(cur); cur.clear(); }
+        else cur += *s;
+    }
+    if (!cur.empty()) v.push_back(cur);
+    return v;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s trace.bin [--frames N,..] [--page-size B,..] [--policy lru,fifo,clock,random,opt]\n"
+                        "       [--read-us U] [--read-us-per-kb U] [--write-us U] [--write-us-per-kb U] [--seed S]\n",
+                argv[0]);
+        return 2;
+    }
+    Log log;
+    if (!load_log(argv[1], log)) return 1;
+
+    std::vector<uint32_t> frames, page_sizes;
+    std::vector<std::string> policies{"lru"};
+    LatencyModel lat;
+    uint32_t seed = 1;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        const std::string opt = argv[i];
+        const char* val = argv[i + 1];
+        if (opt == "--frames") frames = parse_list(val);
+        else if (opt == "--page-size") page_sizes = parse_list(val);
+        else if (opt == "--policy") policies = parse_words(val);
+        else if (opt == "--read-us") lat.read_us = atof(val);
+        else if (opt == "--read-us-per-kb") lat.read_us_per_kb = atof(val);
+        else if (opt == "--write-us") lat.write_us = atof(val);
+        else if (opt == "--write-us-per-kb") lat.write_us_per_kb = atof(val);
+        else if (opt == "--seed") seed = (uint32_t)strtoul(val, nullptr, 10);
+        else {
+            fprintf(stderr, "vm_replay: unknown option %s\n", opt.c_str());
+            return 2;
+        }
+    }
+    for (const std::string& pol : policies) {
+        if (pol != "lru" && pol != "fifo" && pol != "clock" && pol != "random" && pol != "opt") {
+            fprintf(stderr, "vm_replay: unknown policy %s\n", pol.c_str());
+            return 2;
+        }
+    }
+    if (page_sizes.empty()) page_sizes.push_back(log.page_size);
+    if (frames.empty()) {
+        for (uint32_t f = 1; f <= log.page_count; f *= 2) frames.push_back(f);
+        if (frames.back() != log.page_count) frames.push_back(log.page_count);
+    }
+
+    printf("log: %zu records, recorded page size %u, %u pages\n", log.records.size(), log.page_size, log.page_count);
+    printf("%-7s %9s %7s %10s %8s %10s %10s %8s %10s\n", "policy", "page_size", "frames", "accesses", "first",
+           "faults", "writebacks", "fault%", "io_ms");
+    for (const std::string& pol : policies) {
+        for (uint32_t ps : page_sizes) {
+            if (ps == 0) continue;
+            for (uint32_t f : frames) {
+                if (f == 0) continue;
+                const Result r = simulate(log, ps, f, pol, lat, seed);
+                printf("%-7s %9u %7u %10llu %8llu %10llu %10llu %7.2f%% %10.1f\n", pol.c_str(), ps, f,
+                       (unsigned long long)r.accesses, (unsigned long long)r.first_touches, (unsigned long long)r.faults,
+                       (unsigned long long)r.writebacks, r.accesses ? 100.0 * r.faults / r.accesses : 0.0, r.io_ms);
+            }
+        }
+    }
+    return 0;
+}
+
+#endif // !ARDUINO
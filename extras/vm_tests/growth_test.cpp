@@ -0,0 +1,97 @@
+/**
+ * @file growth_test.cpp
+ * @brief Host-side regression test: container growth at the smallest frame limit, where copying
+ * a heap block to a larger one needs both pages resident at once.
+ *
+ * set_frame_limit(1) must yield a usable limit of 2. A VMString and VMVectors of trivial and
+ * non-trivial elements then grow past several reallocations and the flat-to-paged switch, and
+ * every element is checked. Finally a lock set pins all but one frame: growth may then fail,
+ * but only with an exception, leaving the existing contents intact.
+ *
+ * Build: g++ -std=c++17 -g -fsanitize=address,undefined -I. -o growth_test extras/vm_tests/growth_test.cpp
+ */
+
+#if !defined(ARDUINO)
+
+#ifndef VM_PAGE_SIZE
+#define VM_PAGE_SIZE 1024
+#endif
+#ifndef VM_PAGE_COUNT
+#define VM_PAGE_COUNT 64
+#endif
+#include "vm_test.h"
+
+#include <string>
+
+namespace {
+
+/** @brief Element with non-trivial move and destructor, so moves cannot be plain copies. */
+struct Tracked {
+    int v;
+    Tracked(int x = 0) : v(x) {}
+    Tracked(const Tracked&) = default;
+    Tracked(Tracked&& o) noexcept : v(o.v) { o.v = -1; }
+    ~Tracked() { v = -2; }
+};
+
+/// Grow a string and vectors with one frame requested, then verify every element.
+void grow_at_limit_one() {
+    auto session = vm_test::begin_sim(1);
+    if (!session) return;
+    CHECK(VMManager::instance().get_frame_limit() == 2);
+
+    VMString s;
+    std::string expect;
+    VMVector<int> ints;
+    VMVector<Tracked> objs;
+    for (int i = 0; i < 1500; ++i) {
+        if (i < 800) { // a VMString lives in one heap block
+            s.push_back((char)('a' + i % 26));
+            expect.push_back((char)('a' + i % 26));
+        }
+        ints.push_back(i);
+        objs.push_back(Tracked(i));
+    }
+    CHECK(s.size() == expect.size());
+    for (size_t i = 0; i < expect.size(); ++i) CHECK(s.cread(i) == expect[i]);
+    for (int i = 0; i < 1500; ++i) {
+        CHECK(ints.cread(i) == i);
+        CHECK(objs.cread(i).v == i);
+    }
+}
+
+/// With one frame left for paging, growth either succeeds or throws; data already stored survives.
+void grow_beside_lock_set() {
+    auto session = vm_test::begin_sim(3);
+    if (!session) return;
+    VMVector<int> locked;
+    for (int i = 0; i < 400; ++i) locked.push_back(i);
+    VMLockSet rt;
+    rt.add(locked);
+    CHECK(rt.lock());
+    CHECK(rt.frames() == 2); // one frame left for paging
+
+    VMVector<int> v;
+    VMString s;
+    size_t failed = 0;
+    for (int i = 0; i < 1200; ++i) {
+        try {
+            v.push_back(i);
+            if (i < 800) s.push_back('z');
+        } catch (const std::runtime_error&) {
+            ++failed;
+            break;
+        }
+    }
+    for (size_t i = 0; i < v.size(); ++i) CHECK(v.cread(i) == (int)i);
+    for (size_t i = 0; i < s.size(); ++i) CHECK(s.cread(i) == 'z');
+    rt.unlock();
+    for (int i = 0; i < 400; ++i) CHECK(locked.cread(i) == i);
+    printf("lock set: %zu ints, %zu chars stored, %s\n", v.size(), s.size(), failed ? "growth refused" : "growth completed");
+}
+
+} // namespace
+
+int main() { return vm_test::run("growth_test", {grow_at_limit_one, grow_beside_lock_set}); }
+
+#endif // !ARDUINO
@@ -0,0 +1,146 @@
+/**
+ * @file swap_log_test.cpp
+ * @brief Host-side regression test: log-structured swap (VM_SWAP_LOG) holding multi-page
+ * extents of mixed lengths while nearly every page is allocated.
+ *
+ * Extents are written back as one unit into a single segment, so they leave segment tails that
+ * only shorter units can use. The first phase keeps twelve five-page objects cycling through six
+ * frames; the second fills the page table with arrays of 1 to VM_SWAP_LOG_SEGMENT_PAGES pages
+ * and rewrites, frees and reallocates them at random, with and without swap_log_clean(). Every
+ * read is checked against the value last written.
+ *
+ * Build: g++ -std=c++17 -g -fsanitize=address,undefined -I. -o swap_log_test extras/vm_tests/swap_log_test.cpp
+ * Other geometries: add e.g. -DVM_SWAP_LOG_SEGMENT_PAGES=4 -DVM_SWAP_LOG_SPARE_SEGMENTS=2; with
+ * -DVM_SWAP_LOG=0 the same workload runs on fixed swap slots for comparison.
+ */
+
+#if !defined(ARDUINO)
+
+#ifndef VM_PAGE_SIZE
+#define VM_PAGE_SIZE 256
+#endif
+#ifndef VM_PAGE_COUNT
+#define VM_PAGE_COUNT 64
+#endif
+#ifndef VM_SWAP_LOG
+#define VM_SWAP_LOG 1
+#endif
+#include "vm_test.h"
+
+#include <random>
+#include <vector>
+
+namespace {
+
+/// Pages of a Big object: five, or a whole segment when segments are shorter.
+constexpr size_t kBigPages = VM_SWAP_LOG_SEGMENT_PAGES < 5 ? VM_SWAP_LOG_SEGMENT_PAGES : 5;
+
+/** @brief Object spanning kBigPages pages (an extent). */
+struct Big {
+    uint32_t id;
+    uint8_t pad[kBigPages * VM_PAGE_SIZE - 64];
+};
+
+/// Print the log counters of one phase.
+void report(const char* phase) {
+    VMManager::SwapLogStats st;
+    if (!VMManager::instance().swap_log_stats(st)) return;
+    printf("%-8s segments %u free %u live %u appended %u cleaned %u moved %u dropped %u\n", phase,
+           (unsigned)st.segments, (unsigned)st.free_segments, (unsigned)st.live_pages,
+           (unsigned)st.appended_pages, (unsigned)st.cleaned_segments, (unsigned)st.moved_pages,
+           (unsigned)st.dropped_pages);
+}
+
+/// Twelve Big objects through six frames: every access evicts a whole extent.
+void run_objects() {
+    auto session = vm_test::begin_sim(6);
+    if (!session) return;
+    std::vector<VMPtr<Big>> objs;
+    for (uint32_t i = 0; i < 12; ++i) {
+        objs.push_back(make_vm<Big>());
+        objs.back()->id = i;
+        objs.back()->pad[sizeof(Big::pad) - 1] = (uint8_t)i;
+    }
+    for (uint32_t round = 0; round < 30; ++round) {
+        for (uint32_t i = 0; i < objs.size(); ++i) {
+            const Big& b = *static_cast<const VMPtr<Big>&>(objs[i]); // read: no dirtying
+            CHECK(b.id == i);
+            CHECK(b.pad[sizeof(Big::pad) - 1] == (uint8_t)(round ? i + round - 1 : i));
+            objs[i]->pad[sizeof(Big::pad) - 1] = (uint8_t)(i + round);
+        }
+    }
+    report("objects");
+    for (auto& p : objs) p.destroy();
+}
+
+/** @brief One array of whole pages and the byte it was last filled with. */
+struct Extent {
+    VMPtr<uint8_t> ptr;
+    size_t pages;
+    uint8_t value;
+};
+
+/// Fill the first and last byte of every page of e with v.
+void fill(Extent& e, uint8_t v) {
+    for (size_t k = 0; k < e.pages; ++k) {
+        e.ptr[k * VM_PAGE_SIZE] = v;
+        e.ptr[(k + 1) * VM_PAGE_SIZE - 1] = v;
+    }
+    e.value = v;
+}
+
+/// True if every page of e still holds its value.
+bool holds(const Extent& e) {
+    const VMPtr<uint8_t>& p = e.ptr; // const access reads without dirtying the pages
+    for (size_t k = 0; k < e.pages; ++k) {
+        if (p[k * VM_PAGE_SIZE] != e.value) return false;
+        if (p[(k + 1) * VM_PAGE_SIZE - 1] != e.value) return false;
+    }
+    return true;
+}
+
+/// Arrays of mixed extent lengths covering almost all pages, rewritten and reallocated.
+void run_extents(bool clean) {
+    auto session = vm_test::begin_sim(VM_SWAP_LOG_SEGMENT_PAGES + 4);
+    if (!session) return;
+    auto& mgr = VMManager::instance();
+    std::mt19937 rng(7);
+    std::vector<Extent> ext;
+    size_t used = 0;
+    const size_t reserve = 4; // small-heap pages of the VMPtr bookkeeping and spare room
+    while (used + 1 + reserve < VM_PAGE_COUNT) {
+        size_t n = 1 + rng() % VM_SWAP_LOG_SEGMENT_PAGES;
+        if (used + n + reserve > VM_PAGE_COUNT) n = 1;
+        ext.push_back({make_vm_array<uint8_t>(n * VM_PAGE_SIZE), n, 0});
+        fill(ext.back(), (uint8_t)ext.size());
+        used += n;
+    }
+    for (uint32_t r = 0; r < 6000; ++r) {
+        Extent& e = ext[rng() % ext.size()];
+        CHECK(holds(e));
+        if (rng() % 2) fill(e, (uint8_t)rng());
+        if (r % 500 == 499) {
+            destroy_vm_array(e.ptr, e.pages * VM_PAGE_SIZE);
+            e.ptr = make_vm_array<uint8_t>(e.pages * VM_PAGE_SIZE);
+            fill(e, (uint8_t)r);
+        }
+        if (clean && r % 100 == 0) mgr.swap_log_clean(2);
+    }
+    for (const Extent& e : ext) CHECK(holds(e));
+
+#if VM_SWAP_LOG
+    VMManager::SwapLogStats st;
+    CHECK(mgr.swap_log_stats(st));
+    CHECK(st.live_pages <= used);
+#endif
+    report(clean ? "cleaned" : "extents");
+    for (Extent& e : ext) destroy_vm_array(e.ptr, e.pages * VM_PAGE_SIZE);
+}
+
+} // namespace
+
+int main() {
+    return vm_test::run("swap_log_test", {run_objects, [] { run_extents(false); }, [] { run_extents(true); }});
+}
+
+#endif // !ARDUINO
@@ -0,0 +1,97 @@
+/**
+ * @file vm_test.h
+ * @brief Scaffolding shared by the host tests in extras/vm_tests: a non-fatal CHECK, a manager
+ * session on a simulated backend, and a main() helper that runs the scenarios.
+ *
+ * Define any VM_* configuration before including this header; it includes containers.h.
+ */
+
+#pragma once
+
+#if !defined(ARDUINO)
+
+#include "containers.h"
+
+#include <cstdio>
+#include <initializer_list>
+#include <stdexcept>
+
+namespace vm_test {
+
+inline int failures = 0; ///< Failed checks so far.
+
+/// Report a failed check without stopping, so one run lists every broken case.
+#define CHECK(cond)                                                                  \
+    do {                                                                             \
+        if (!(cond)) {                                                               \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);  \
+            ++vm_test::failures;                                                     \
+        }                                                                            \
+    } while (0)
+
+/**
+ * @brief VMManager started on a VMSimSwapBackend with a frame limit, ended on destruction.
+ *
+ * @details Declare it before the objects of a scenario so they are destroyed first. A failed
+ * begin() counts as a failed check; test the session before using it.
+ */
+class SimSession {
+public:
+    /// Set the frame limit and start the manager (0 = no limit).
+    explicit SimSession(size_t frames) {
+        auto& mgr = VMManager::instance();
+        mgr.set_frame_limit(frames);
+        ok_ = mgr.begin(sim_);
+        if (!ok_) {
+            fprintf(stderr, "VMManager::begin() failed\n");
+            ++failures;
+        }
+    }
+    ~SimSession() {
+        auto& mgr = VMManager::instance();
+        if (ok_) mgr.end();
+        mgr.set_frame_limit(0);
+    }
+    SimSession(const SimSession&) = delete;
+    SimSession& operator=(const SimSession&) = delete;
+
+    /// True if begin() succeeded.
+    explicit operator bool() const { return ok_; }
+    /// The backend, for its I/O counters.
+    VMSimSwapBackend& backend() { return sim_; }
+
+private:
+    VMSimSwapBackend sim_; ///< Swap area of this session.
+    bool ok_ = false;      ///< begin() succeeded.
+};
+
+/**
+ * @brief Start a session: `auto s = vm_test::begin_sim(4); if (!s) return;`.
+ * @param frames Frame limit (0 = none).
+ */
+inline SimSession begin_sim(size_t frames) { return SimSession(frames); }
+
+/**
+ * @brief Run scenarios in order and report the result.
+ * @param name Test name for the summary line.
+ * @param scenarios Functions to run; an escaping exception counts as a failure.
+ * @return Exit status: 0 if every check passed, else 1.
+ */
+inline int run(const char* name, std::initializer_list<void (*)()> scenarios) {
+    try {
+        for (auto scenario : scenarios) scenario();
+    } catch (const std::exception& e) {
+        fprintf(stderr, "%s: %s\n", name, e.what());
+        ++failures;
+    }
+    if (failures) {
+        printf("%s: %d check(s) failed\n", name, failures);
+        return 1;
+    }
+    printf("%s: ok\n", name);
+    return 0;
+}
+
+} // namespace vm_test
+
+#endif // !ARDUINO